@@ -0,0 +1,82 @@
+#include "Benchmark.h"
+#include <iomanip>
+
+namespace
+{
+	volatile std::uint64_t sink = 0;
+}
+
+void keep(std::uint64_t _value)
+{
+	sink = sink + _value;
+}
+
+BenchmarkRunner::BenchmarkRunner(std::chrono::milliseconds _minTime, const std::string& _filter) :
+	minTime(_minTime),
+	filter(_filter)
+{
+}
+
+bool BenchmarkRunner::wants(const std::string& _name) const
+{
+	return filter.empty() || _name.find(filter) != std::string::npos;
+}
+
+void BenchmarkRunner::run(const std::string& _name, int _count, const std::function<void()>& _setup, const std::function<void()>& _body)
+{
+	if (!wants(_name)) {
+		return;
+	}
+	using Clock = std::chrono::steady_clock;
+
+	_setup();
+	_body(); //warm caches and let any lazy allocation happen outside the timing
+
+	std::uint64_t batch = 1;
+	Clock::duration elapsed{};
+	while (true)
+	{
+		Clock::time_point start = Clock::now();
+		for (std::uint64_t i = 0; i < batch; ++i) {
+			_body();
+		}
+		elapsed = Clock::now() - start;
+		if (elapsed >= minTime || batch >= (1ull << 40)) {
+			break;
+		}
+		batch *= 2;
+	}
+
+	BenchmarkResult result;
+	result.name = _name;
+	result.count = _count;
+	result.iterations = batch;
+	result.nanosPerOp = std::chrono::duration<double, std::nano>(elapsed).count() / batch;
+	result.nanosPerItem = result.nanosPerOp / (_count > 0 ? _count : 1);
+	results.push_back(result);
+}
+
+void BenchmarkRunner::writeCsv(std::ostream& _out) const
+{
+	_out << "name,count,iterations,ns_per_op,ns_per_item" << "\n";
+	_out << std::fixed << std::setprecision(2);
+	for (const BenchmarkResult& result : results) {
+		_out << result.name << "," << result.count << "," << result.iterations << ","
+			<< result.nanosPerOp << "," << result.nanosPerItem << "\n";
+	}
+}
+
+void BenchmarkRunner::writeJson(std::ostream& _out) const
+{
+	_out << std::fixed << std::setprecision(2);
+	_out << "{\"benchmarks\":[" << "\n";
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		const BenchmarkResult& result = results[i];
+		_out << "  {\"name\":\"" << result.name << "\",\"count\":" << result.count
+			<< ",\"iterations\":" << result.iterations
+			<< ",\"ns_per_op\":" << result.nanosPerOp
+			<< ",\"ns_per_item\":" << result.nanosPerItem << "}"
+			<< (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	_out << "]}" << "\n";
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// one measured case, per op is one call of the body, per item divides that by the entity count
+struct BenchmarkResult
+{
+	std::string name;
+	int count = 0; //players, messages or whatever the case scales with
+	std::uint64_t iterations = 0;
+	double nanosPerOp = 0.0;
+	double nanosPerItem = 0.0;
+};
+
+/// <summary>
+/// runs each case for at least a minimum time in growing batches and keeps the results
+/// so a run can be written out once at the end and diffed against another build
+/// </summary>
+class BenchmarkRunner
+{
+public:
+	BenchmarkRunner(std::chrono::milliseconds _minTime, const std::string& _filter);
+
+	bool wants(const std::string& _name) const; //false if the filter rules the case out
+
+	/// <summary>
+	/// times _body, calling it in batches that double until one batch takes _minTime
+	/// _setup runs once before timing and is not counted
+	/// </summary>
+	void run(const std::string& _name, int _count, const std::function<void()>& _setup, const std::function<void()>& _body);
+
+	void writeCsv(std::ostream& _out) const;
+	void writeJson(std::ostream& _out) const;
+
+private:
+	std::chrono::milliseconds minTime;
+	std::string filter;
+	std::vector<BenchmarkResult> results;
+};
+
+/// <summary>
+/// keeps a value the optimiser would otherwise see is never used, so the work producing it is not thrown away
+/// </summary>
+void keep(std::uint64_t _value);
@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "Protocol.h"
+#include "Simulation.h"
+#include "Snapshot.h"
+#include "SpatialHash.h"
+#include "StreamBuffer.h"
+#include "TimerWheel.h"
+
+namespace
+{
+	struct BenchConfig
+	{
+		std::string format = "csv";
+		std::string filter; //only cases whose name contains this
+		std::string outPath; //stdout when empty
+		int minTimeMs = 200; //per case
+	};
+
+	/// <summary>
+	/// reads --format, --filter, --out and --min-time
+	/// </summary>
+	bool parseArguments(int argc, char* argv[], BenchConfig& _config)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string argument = argv[i];
+			if (argument == "--format" && i + 1 < argc) {
+				_config.format = argv[++i];
+			}
+			else if (argument == "--filter" && i + 1 < argc) {
+				_config.filter = argv[++i];
+			}
+			else if (argument == "--out" && i + 1 < argc) {
+				_config.outPath = argv[++i];
+			}
+			else if (argument == "--min-time" && i + 1 < argc) {
+				_config.minTimeMs = std::atoi(argv[++i]);
+			}
+			else {
+				std::cerr << "usage: " << argv[0] << " [--format csv|json] [--filter name] [--out file] [--min-time 200]" << "\n";
+				return false;
+			}
+		}
+		if (_config.format != "csv" && _config.format != "json") {
+			std::cerr << "format is csv or json" << "\n";
+			return false;
+		}
+		if (_config.minTimeMs <= 0) {
+			std::cerr << "min time must be positive" << "\n";
+			return false;
+		}
+		return true;
+	}
+
+	/// directions for inputs, drawn up front so the random generator is not what gets timed
+	std::vector<int> makeDirections(std::size_t _count)
+	{
+		std::mt19937 random(1);
+		std::uniform_int_distribution<int> direction(-1, 1);
+		std::vector<int> directions(_count);
+		for (int& value : directions) {
+			value = direction(random);
+		}
+		return directions;
+	}
+
+	std::vector<PlayerState> makePlayers(int _count)
+	{
+		std::mt19937 random(2);
+		std::uniform_real_distribution<float> x(0.f, static_cast<float>(SCREEN_WIDTH));
+		std::uniform_real_distribution<float> y(0.f, static_cast<float>(SCREEN_HEIGHT));
+		std::vector<PlayerState> players(_count);
+		for (int i = 0; i < _count; ++i) {
+			players[i].id = i;
+			players[i].x = Fixed::fromFloat(x(random));
+			players[i].y = Fixed::fromFloat(y(random));
+		}
+		return players;
+	}
+
+	Snapshot makeSnapshot(int _count, std::uint32_t _tick)
+	{
+		std::mt19937 random(3);
+		std::uniform_int_distribution<int> x(0, (1 << POSITION_X.bits) - 1);
+		std::uniform_int_distribution<int> y(0, (1 << POSITION_Y.bits) - 1);
+		Snapshot snapshot;
+		snapshot.tick = _tick;
+		for (int i = 0; i < _count; ++i) {
+			SnapshotPlayer player;
+			player.id = SlotID::make(i, 1);
+			player.x = static_cast<std::uint16_t>(x(random));
+			player.y = static_cast<std::uint16_t>(y(random));
+			player.isIt = i == 0;
+			snapshot.players.push_back(player);
+		}
+		return snapshot;
+	}
+
+	/// <summary>
+	/// whole ticks with every player sending an input, a tag restarts on the next tick
+	/// instead of freezing for seconds so nearly every timed tick is one where people play
+	/// </summary>
+	void benchSimulation(BenchmarkRunner& _runner)
+	{
+		const std::vector<int> directions = makeDirections(4096);
+		for (int count : { 10, 100, 1000 }) //a room holds at most SlotID::MAX_SLOTS
+		{
+			SimulationConfig config;
+			config.maxPlayers = count;
+			config.gameOverDelay = 0.f;
+			std::unique_ptr<Simulation> simulation;
+			std::vector<int> ids;
+			std::size_t next = 0;
+
+			_runner.run("simulation.step", count,
+				[&] {
+					simulation = std::make_unique<Simulation>(config);
+					ids.clear();
+					for (int i = 0; i < count; ++i) {
+						ids.push_back(simulation->addPlayer());
+					}
+				},
+				[&] {
+					for (int id : ids) {
+						simulation->queueInput(id, directions[next % directions.size()], directions[(next + 1) % directions.size()]);
+						next += 2;
+					}
+					simulation->step();
+				});
+		}
+	}
+
+	/// <summary>
+	/// one input applied to every player, movement plus the wrap at the screen edges
+	/// </summary>
+	void benchMovement(BenchmarkRunner& _runner)
+	{
+		const std::vector<int> directions = makeDirections(4096);
+		for (int count : { 10, 1000, 10000 })
+		{
+			std::vector<PlayerState> players;
+			std::size_t next = 0;
+			_runner.run("movement.apply", count,
+				[&] { players = makePlayers(count); },
+				[&] {
+					std::uint64_t wrapped = 0;
+					for (PlayerState& player : players) {
+						wrapped += Simulation::applyMovement(player, directions[next % directions.size()], directions[(next + 1) % directions.size()]);
+						next += 2;
+					}
+					keep(wrapped);
+				});
+		}
+	}
+
+	/// <summary>
+	/// the collision broad phase as if every player were it, move everyone then ask the grid who is near each of them
+	/// </summary>
+	void benchGrid(BenchmarkRunner& _runner)
+	{
+		const std::vector<int> directions = makeDirections(4096);
+		for (int count : { 10, 1000, 10000 })
+		{
+			std::vector<PlayerState> players;
+			std::unique_ptr<SpatialHash> grid;
+			std::vector<int> candidates;
+			std::size_t next = 0;
+			_runner.run("grid.update_query", count,
+				[&] {
+					players = makePlayers(count);
+					grid = std::make_unique<SpatialHash>(Fixed::fromFloat(PLAYER_RADIUS * 4.f));
+				},
+				[&] {
+					for (PlayerState& player : players) {
+						Simulation::applyMovement(player, directions[next % directions.size()], directions[(next + 1) % directions.size()]);
+						next += 2;
+						grid->update(player.id, player.x, player.y);
+					}
+					std::uint64_t found = 0;
+					for (const PlayerState& player : players) {
+						candidates.clear();
+						grid->query(player.x, player.y, Fixed::fromFloat(PLAYER_RADIUS * 2.f), candidates);
+						found += candidates.size();
+					}
+					keep(found);
+				});
+		}
+	}
+
+	/// <summary>
+	/// one tick of a wheel holding count timers, each one that fires is set going again up to ten seconds out
+	/// like effects that keep being picked up, the cost per timer should not grow with the count
+	/// </summary>
+	void benchTimers(BenchmarkRunner& _runner)
+	{
+		const int tickRate = 60;
+		std::vector<std::uint32_t> delays(4096);
+		std::mt19937 random(3);
+		std::uniform_int_distribution<std::uint32_t> delay(1, tickRate * 10);
+		for (std::uint32_t& value : delays) {
+			value = delay(random);
+		}
+		for (int count : { 10, 1000, 100000 })
+		{
+			std::unique_ptr<TimerWheel<int>> timers;
+			std::uint64_t tick = 0;
+			std::size_t next = 0;
+			_runner.run("timers.tick", count,
+				[&] {
+					timers = std::make_unique<TimerWheel<int>>(1);
+					tick = 0;
+					for (int i = 0; i < count; ++i) {
+						timers->schedule(1 + delays[next++ % delays.size()], i);
+					}
+				},
+				[&] {
+					++tick;
+					int fired = 0;
+					timers->advance(tick, [&](int _timer) {
+						timers->schedule(tick + delays[next++ % delays.size()], _timer);
+						++fired;
+					});
+					keep(fired);
+				});
+		}
+	}
+
+	/// <summary>
+	/// snapshot deltas against the empty world, which is what a joining client gets,
+	/// and against the last tick with a quarter of the players moved, which is the steady state
+	/// </summary>
+	void benchSnapshots(BenchmarkRunner& _runner)
+	{
+		for (int count : { 10, 50, static_cast<int>(MAX_SNAPSHOT_PLAYERS) })
+		{
+			Snapshot empty;
+			Snapshot previous = makeSnapshot(count, 1);
+			Snapshot current = previous;
+			current.tick = 2;
+			for (std::size_t i = 0; i < current.players.size(); i += 4) {
+				current.players[i].x = static_cast<std::uint16_t>((current.players[i].x + 3) % (1 << POSITION_X.bits));
+			}
+			char buffer[MAX_DATAGRAM_SIZE];
+			Snapshot decoded;
+			std::size_t size = 0;
+
+			_runner.run("snapshot.encode_full", count, [] {},
+				[&] { keep(encodeSnapshotDelta(empty, current, 0, 0, buffer)); });
+			_runner.run("snapshot.encode_delta", count, [] {},
+				[&] { keep(encodeSnapshotDelta(previous, current, 0, 0, buffer)); });
+			_runner.run("snapshot.decode_full", count,
+				[&] { size = encodeSnapshotDelta(empty, current, 0, 0, buffer); },
+				[&] { keep(decodeSnapshotDelta(empty, buffer + sizeof(MessageHeader), size - sizeof(MessageHeader), decoded)); });
+			_runner.run("snapshot.decode_delta", count,
+				[&] { size = encodeSnapshotDelta(previous, current, 0, 0, buffer); },
+				[&] { keep(decodeSnapshotDelta(previous, buffer + sizeof(MessageHeader), size - sizeof(MessageHeader), decoded)); });
+		}
+	}
+
+	/// <summary>
+	/// input messages encoded back to back, then read out of a stream buffer in recv sized pieces like the reactor does
+	/// </summary>
+	void benchFraming(BenchmarkRunner& _runner)
+	{
+		for (int count : { 10, 1000, 10000 })
+		{
+			std::vector<char> bytes(count * messageSize<PlayerInputMessage>());
+			StreamBuffer stream;
+
+			_runner.run("protocol.encode_input", count, [] {},
+				[&] {
+					for (int i = 0; i < count; ++i) {
+						PlayerInputMessage input{ static_cast<std::uint32_t>(i), 0, 1, -1 };
+						encodeMessage(input, static_cast<std::uint32_t>(i), bytes.data() + i * messageSize<PlayerInputMessage>());
+					}
+					keep(static_cast<unsigned char>(bytes[bytes.size() - 1]));
+				});
+
+			_runner.run("protocol.frame_input", count, [] {},
+				[&] {
+					std::uint64_t total = 0;
+					std::size_t offset = 0;
+					while (offset < bytes.size()) {
+						std::size_t chunk = std::min(stream.writableBytes(), bytes.size() - offset);
+						std::memcpy(stream.writePointer(), bytes.data() + offset, chunk);
+						stream.commitWrite(chunk);
+						offset += chunk;
+
+						MessageHeader header;
+						const char* payload = nullptr;
+						while (stream.nextFrame(header, payload) == FrameStatus::Complete) {
+							total += decodePayload<PlayerInputMessage>(payload).inputSequence;
+						}
+					}
+					keep(total);
+				});
+		}
+	}
+}
+
+/// <summary>
+/// times the simulation and protocol hot paths at growing entity counts and writes one row per case,
+/// run it before and after a change and diff the two files
+/// </summary>
+/// <returns>success or failure</returns>
+int main(int argc, char* argv[])
+{
+	BenchConfig config;
+	if (!parseArguments(argc, argv, config)) {
+		return 1;
+	}
+
+	BenchmarkRunner runner(std::chrono::milliseconds(config.minTimeMs), config.filter);
+	std::streambuf* console = std::cout.rdbuf(nullptr); //the simulation logs tags, keep that out of the results
+	benchSimulation(runner);
+	benchMovement(runner);
+	benchGrid(runner);
+	benchTimers(runner);
+	benchSnapshots(runner);
+	benchFraming(runner);
+	std::cout.rdbuf(console);
+
+	std::ofstream file;
+	if (!config.outPath.empty()) {
+		file.open(config.outPath);
+		if (!file) {
+			std::cerr << "Could not open " << config.outPath << "\n";
+			return 1;
+		}
+	}
+	std::ostream& out = config.outPath.empty() ? std::cout : file;
+	if (config.format == "json") {
+		runner.writeJson(out);
+	}
+	else {
+		runner.writeCsv(out);
+	}
+	return 0;
+}
@@ -0,0 +1,228 @@
+#include "Bot.h"
+#include <iostream>
+
+void BotStats::drainInto(BotStats& _total)
+{
+	_total.snapshots += snapshots;
+	_total.staleSnapshots += staleSnapshots;
+	_total.bytesIn += bytesIn;
+	_total.bytesOut += bytesOut;
+	_total.connects += connects;
+	_total.connectFailures += connectFailures;
+	_total.disconnects += disconnects;
+	_total.roundTrips.insert(_total.roundTrips.end(), roundTrips.begin(), roundTrips.end());
+
+	snapshots = staleSnapshots = bytesIn = bytesOut = 0;
+	connects = connectFailures = disconnects = 0;
+	roundTrips.clear(); //capacity is kept
+}
+
+Bot::Bot(const BotConfig& _config, std::uint32_t _seed) :
+	config(_config),
+	random(_seed)
+{
+}
+
+Bot::~Bot()
+{
+	disconnect();
+}
+
+/// <summary>
+/// connects over tcp and opens the udp socket, the host links it once AssignID has given us a token
+/// </summary>
+bool Bot::connect(BotStats& _stats)
+{
+	stream = connectTo(config.host, config.port);
+	if (stream == INVALID_SOCKET_HANDLE) {
+		++_stats.connectFailures;
+		return false;
+	}
+	++_stats.connects;
+
+	if (config.useDatagrams && resolveAddress(config.host, config.port, hostAddress)) {
+		datagram = openDatagramSocket(0);
+	}
+	nextInput = nextTurn = Clock::now();
+	return true;
+}
+
+void Bot::disconnect()
+{
+	if (stream != INVALID_SOCKET_HANDLE) {
+		closeSocket(stream);
+		stream = INVALID_SOCKET_HANDLE;
+	}
+	if (datagram != INVALID_SOCKET_HANDLE) {
+		closeSocket(datagram);
+		datagram = INVALID_SOCKET_HANDLE;
+	}
+}
+
+void Bot::service(Clock::time_point _now, bool _streamReadable, bool _datagramReadable, BotStats& _stats)
+{
+	if (_streamReadable) {
+		receiveStream(_now, _stats);
+	}
+	if (!isConnected()) {
+		return;
+	}
+	if (_datagramReadable) {
+		receiveDatagrams(_now, _stats);
+	}
+
+	if (datagram != INVALID_SOCKET_HANDLE && udpToken != 0 && !udpBound && _now >= nextHello) { //hellos can get lost too
+		sendMessage(UdpHelloMessage{ udpToken }, true, _stats);
+		nextHello = _now + std::chrono::milliseconds(250);
+	}
+	if (udpToken != 0 && _now >= nextInput) {
+		sendInput(_now, _stats);
+	}
+}
+
+void Bot::receiveStream(Clock::time_point _now, BotStats& _stats)
+{
+	int received = receiveBytes(stream, streamBuffer.writePointer(), streamBuffer.writableBytes());
+	if (received <= 0) {
+		++_stats.disconnects; //closed by the server or reset, either way this bot is gone
+		disconnect();
+		return;
+	}
+	_stats.bytesIn += received;
+	streamBuffer.commitWrite(received);
+
+	MessageHeader header;
+	const char* payload = nullptr;
+	FrameStatus status;
+	while ((status = streamBuffer.nextFrame(header, payload)) == FrameStatus::Complete)
+	{
+		switch (static_cast<MessageType>(header.type))
+		{
+		case MessageType::AssignID: {
+			AssignIDMessage assign = decodePayload<AssignIDMessage>(payload);
+			udpToken = assign.udpToken;
+			int tickRate = assign.tickRate > 0 ? assign.tickRate : 60;
+			inputInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / tickRate));
+			break;
+		}
+		case MessageType::Snapshot: //over tcp until udp is linked
+			handleSnapshot(payload, header.length, _now, _stats);
+			break;
+		default:
+			break;
+		}
+	}
+	if (status == FrameStatus::Malformed) {
+		std::cerr << "Malformed data from host, dropping bot." << "\n";
+		++_stats.disconnects;
+		disconnect();
+	}
+}
+
+void Bot::receiveDatagrams(Clock::time_point _now, BotStats& _stats)
+{
+	char buffer[MAX_DATAGRAM_SIZE];
+	SocketAddress from;
+	int received;
+	while ((received = receiveDatagram(datagram, buffer, sizeof(buffer), from)) > 0) {
+		if (!sameAddress(from, hostAddress)) {
+			continue;
+		}
+		_stats.bytesIn += received;
+		forEachMessage(buffer, received, [&](const MessageHeader& _header, const char* _payload) {
+			switch (static_cast<MessageType>(_header.type))
+			{
+			case MessageType::UdpHello:
+				udpBound = udpBound || decodePayload<UdpHelloMessage>(_payload).udpToken == udpToken;
+				break;
+			case MessageType::Snapshot:
+				handleSnapshot(_payload, _header.length, _now, _stats);
+				break;
+			default:
+				break;
+			}
+		});
+	}
+}
+
+/// <summary>
+/// applies a snapshot the same way the real client does and times every input it says was applied,
+/// so the round trip includes the wait for the next tick and snapshot just like a player feels it
+/// </summary>
+void Bot::handleSnapshot(const char* _payload, std::size_t _size, Clock::time_point _now, BotStats& _stats)
+{
+	SnapshotMessage fixed = decodePayload<SnapshotMessage>(_payload);
+	if (!isNewerSequence(fixed.tick, lastSnapshotTick)) {
+		++_stats.staleSnapshots;
+		return;
+	}
+	const Snapshot* baseline = snapshots.find(fixed.baselineTick);
+	if (baseline == nullptr || !decodeSnapshotDelta(*baseline, _payload, _size, decoded)) {
+		++_stats.staleSnapshots;
+		return;
+	}
+	++_stats.snapshots;
+
+	if (isNewerSequence(fixed.lastInput, acknowledgedInput) && !isNewerSequence(fixed.lastInput, inputSequence)) {
+		std::uint32_t first = fixed.lastInput - acknowledgedInput > INPUT_HISTORY ? fixed.lastInput - INPUT_HISTORY + 1 : acknowledgedInput + 1;
+		for (std::uint32_t sequence = first; sequence != fixed.lastInput + 1; ++sequence) {
+			std::chrono::duration<float, std::milli> roundTrip = _now - inputSent[sequence % INPUT_HISTORY];
+			_stats.roundTrips.push_back(roundTrip.count());
+		}
+		acknowledgedInput = fixed.lastInput;
+	}
+
+	Snapshot& stored = snapshots.store(decoded.tick);
+	stored = decoded;
+	lastSnapshotTick = decoded.tick;
+
+	sendMessage(SnapshotAckMessage{ udpToken, lastSnapshotTick }, udpBound, _stats);
+}
+
+/// <summary>
+/// one input per host tick while moving, standing still sends nothing just like the real client
+/// </summary>
+void Bot::sendInput(Clock::time_point _now, BotStats& _stats)
+{
+	nextInput += inputInterval;
+	if (_now - nextInput > std::chrono::seconds(1)) {
+		nextInput = _now; //fell far behind, dont send a burst
+	}
+	if (_now >= nextTurn) {
+		chooseDirection();
+	}
+	if (xDir == 0 && yDir == 0) {
+		return;
+	}
+
+	++inputSequence;
+	inputSent[inputSequence % INPUT_HISTORY] = _now;
+	sendMessage(PlayerInputMessage{ inputSequence, lastSnapshotTick, static_cast<std::int8_t>(xDir), static_cast<std::int8_t>(yDir) }, false, _stats);
+}
+
+void Bot::chooseDirection()
+{
+	switch (config.movement)
+	{
+	case BotMovement::Random: {
+		std::uniform_int_distribution<int> direction(-1, 1);
+		std::uniform_int_distribution<int> hold(300, 1000);
+		xDir = direction(random);
+		yDir = direction(random);
+		nextTurn += std::chrono::milliseconds(hold(random));
+		break;
+	}
+	case BotMovement::Sweep: {
+		static const int SWEEP[8][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+		xDir = SWEEP[sweepStep][0];
+		yDir = SWEEP[sweepStep][1];
+		sweepStep = (sweepStep + 1) % 8;
+		nextTurn += std::chrono::milliseconds(500);
+		break;
+	}
+	case BotMovement::Idle:
+		xDir = yDir = 0;
+		nextTurn += std::chrono::hours(1);
+		break;
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include "Protocol.h"
+#include "Snapshot.h"
+#include "Socket.h"
+#include "StreamBuffer.h"
+
+enum class BotMovement
+{
+	Random, //picks a new direction every so often
+	Sweep, //turns through all eight directions in order
+	Idle //never moves, only acks snapshots
+};
+
+struct BotConfig
+{
+	std::string host = "127.0.0.1";
+	unsigned short port = 53000;
+	BotMovement movement = BotMovement::Random;
+	bool useDatagrams = true; //link udp like the real client, otherwise snapshots stay on tcp
+};
+
+/// <summary>
+/// what a group of bots saw since the last report, each bot thread fills its own and the reporter drains them
+/// </summary>
+struct BotStats
+{
+	std::mutex mutex; //held by the bot thread while it services its bots and by the reporter while it drains
+
+	std::uint64_t snapshots = 0; //applied
+	std::uint64_t staleSnapshots = 0; //overtaken or missing their baseline
+	std::uint64_t bytesIn = 0;
+	std::uint64_t bytesOut = 0;
+	std::uint64_t connects = 0;
+	std::uint64_t connectFailures = 0;
+	std::uint64_t disconnects = 0; //dropped by the server or the network after connecting
+	std::vector<float> roundTrips; //milliseconds from sending an input to a snapshot saying it was applied
+
+	void drainInto(BotStats& _total); //adds everything to _total and starts again from zero
+};
+
+/// <summary>
+/// one simulated player, speaks the same protocol as the windowed client without drawing anything
+/// one thread polls the sockets of many bots and services the ones with something to do
+/// </summary>
+class Bot
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	Bot(const BotConfig& _config, std::uint32_t _seed);
+	~Bot();
+
+	Bot(const Bot&) = delete;
+	Bot& operator=(const Bot&) = delete;
+
+	bool connect(BotStats& _stats); //blocking connect, false if refused
+	void disconnect();
+
+	/// <summary>
+	/// reads what the poll said is waiting, then sends any input or hello that is due
+	/// the tcp socket stays blocking like the real clients, so it is only read when readable
+	/// </summary>
+	void service(Clock::time_point _now, bool _streamReadable, bool _datagramReadable, BotStats& _stats);
+
+	bool isConnected() const { return stream != INVALID_SOCKET_HANDLE; }
+	SocketHandle getStreamSocket() const { return stream; }
+	SocketHandle getDatagramSocket() const { return datagram; }
+	Clock::time_point getNextInput() const { return nextInput; }
+
+private:
+	void receiveStream(Clock::time_point _now, BotStats& _stats); //one read, it will not block after a poll
+	void receiveDatagrams(Clock::time_point _now, BotStats& _stats);
+	void handleSnapshot(const char* _payload, std::size_t _size, Clock::time_point _now, BotStats& _stats);
+	void sendInput(Clock::time_point _now, BotStats& _stats);
+	void chooseDirection();
+
+	template<typename T>
+	void sendMessage(const T& _payload, bool _overDatagram, BotStats& _stats);
+
+	const BotConfig& config;
+	std::mt19937 random;
+
+	SocketHandle stream = INVALID_SOCKET_HANDLE;
+	SocketHandle datagram = INVALID_SOCKET_HANDLE;
+	SocketAddress hostAddress{};
+	StreamBuffer streamBuffer;
+
+	std::uint32_t udpToken = 0; //0 until AssignID arrives
+	bool udpBound = false;
+	Clock::time_point nextHello{};
+
+	Clock::duration inputInterval = std::chrono::milliseconds(16); //one input per host tick, set from AssignID
+	Clock::time_point nextInput{};
+	Clock::time_point nextTurn{};
+	int xDir = 0;
+	int yDir = 0;
+	int sweepStep = 0;
+
+	std::uint32_t outgoingSequence = 0;
+	std::uint32_t inputSequence = 0;
+	std::uint32_t acknowledgedInput = 0;
+	static const std::size_t INPUT_HISTORY = 256; //inputs in flight we can still time
+	std::array<Clock::time_point, INPUT_HISTORY> inputSent{};
+
+	SnapshotHistory snapshots;
+	Snapshot decoded;
+	std::uint32_t lastSnapshotTick = 0;
+};
+
+/// <summary>
+/// encodes one message and sends it, over udp if asked and linked, tcp otherwise
+/// </summary>
+template<typename T>
+void Bot::sendMessage(const T& _payload, bool _overDatagram, BotStats& _stats)
+{
+	char buffer[messageSize<T>()];
+	encodeMessage(_payload, outgoingSequence++, buffer);
+
+	int sent = _overDatagram ? sendDatagram(datagram, hostAddress, buffer, sizeof(buffer)) : sendBytes(stream, buffer, sizeof(buffer));
+	if (sent > 0) {
+		_stats.bytesOut += sent;
+	}
+}
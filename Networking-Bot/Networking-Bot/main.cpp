@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Bot.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+namespace
+{
+	volatile std::sig_atomic_t stopRequested = 0;
+
+	void onSignal(int)
+	{
+		stopRequested = 1;
+	}
+
+	struct LoadConfig
+	{
+		BotConfig bot;
+		int clients = 16;
+		int threads = 2;
+		int connectRate = 50; //new connections a second, so a big run does not arrive as one burst
+		int duration = 0; //seconds, 0 runs until ctrl+c
+	};
+
+	/// <summary>
+	/// reads --host, --port, --clients, --threads, --connect-rate, --duration, --movement and --no-udp
+	/// </summary>
+	bool parseArguments(int argc, char* argv[], LoadConfig& _config)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string argument = argv[i];
+			if (argument == "--host" && i + 1 < argc) {
+				_config.bot.host = argv[++i];
+			}
+			else if (argument == "--port" && i + 1 < argc) {
+				_config.bot.port = static_cast<unsigned short>(std::atoi(argv[++i]));
+			}
+			else if (argument == "--clients" && i + 1 < argc) {
+				_config.clients = std::atoi(argv[++i]);
+			}
+			else if (argument == "--threads" && i + 1 < argc) {
+				_config.threads = std::atoi(argv[++i]);
+			}
+			else if (argument == "--connect-rate" && i + 1 < argc) {
+				_config.connectRate = std::atoi(argv[++i]);
+			}
+			else if (argument == "--duration" && i + 1 < argc) {
+				_config.duration = std::atoi(argv[++i]);
+			}
+			else if (argument == "--movement" && i + 1 < argc) {
+				std::string movement = argv[++i];
+				if (movement == "random") {
+					_config.bot.movement = BotMovement::Random;
+				}
+				else if (movement == "sweep") {
+					_config.bot.movement = BotMovement::Sweep;
+				}
+				else if (movement == "idle") {
+					_config.bot.movement = BotMovement::Idle;
+				}
+				else {
+					std::cerr << "movement is random, sweep or idle" << "\n";
+					return false;
+				}
+			}
+			else if (argument == "--no-udp") {
+				_config.bot.useDatagrams = false;
+			}
+			else {
+				std::cerr << "usage: " << argv[0] << " [--host 127.0.0.1] [--port 53000] [--clients 16] [--threads 2] [--connect-rate 50]"
+					<< " [--duration 0] [--movement random|sweep|idle] [--no-udp]" << "\n";
+				return false;
+			}
+		}
+		if (_config.clients <= 0 || _config.threads <= 0 || _config.connectRate <= 0 || _config.duration < 0) {
+			std::cerr << "clients, threads and connect rate must be positive" << "\n";
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// connects its share of the bots on schedule, then waits on all their sockets at once
+	/// and services whichever have data or an input due
+	/// </summary>
+	void runBots(const LoadConfig& _config, int _thread, BotStats& _stats, const std::atomic<bool>& _stop)
+	{
+		using Clock = Bot::Clock;
+		Clock::time_point start = Clock::now();
+
+		std::vector<std::unique_ptr<Bot>> bots;
+		std::vector<Clock::time_point> connectAt;
+		for (int i = _thread; i < _config.clients; i += _config.threads) {
+			bots.push_back(std::make_unique<Bot>(_config.bot, static_cast<std::uint32_t>(i + 1)));
+			connectAt.push_back(start + std::chrono::microseconds(1000000LL * i / _config.connectRate));
+		}
+		std::size_t connected = 0; //bots before this have been connected, or tried to
+
+		std::vector<pollfd> pollSet;
+		std::vector<std::size_t> pollOwners; //bot index for each stream socket entry, its datagram socket follows when it has one
+		while (!_stop)
+		{
+			Clock::time_point now = Clock::now();
+			while (connected < bots.size() && now >= connectAt[connected]) {
+				std::lock_guard<std::mutex> lock(_stats.mutex);
+				bots[connected++]->connect(_stats);
+			}
+
+			Clock::time_point wake = connected < bots.size() ? connectAt[connected] : now + std::chrono::milliseconds(10);
+			pollSet.clear();
+			pollOwners.clear();
+			for (std::size_t i = 0; i < connected; ++i)
+			{
+				if (!bots[i]->isConnected()) {
+					continue;
+				}
+				pollSet.push_back({ bots[i]->getStreamSocket(), POLLIN, 0 });
+				pollOwners.push_back(i);
+				if (bots[i]->getDatagramSocket() != INVALID_SOCKET_HANDLE) {
+					pollSet.push_back({ bots[i]->getDatagramSocket(), POLLIN, 0 });
+				}
+				wake = std::min(wake, bots[i]->getNextInput());
+			}
+
+			int timeout = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count());
+			timeout = std::clamp(timeout, 0, 10);
+			if (pollSet.empty()) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+			}
+			else {
+#ifdef _WIN32
+				WSAPoll(pollSet.data(), static_cast<ULONG>(pollSet.size()), timeout);
+#else
+				::poll(pollSet.data(), pollSet.size(), timeout);
+#endif
+			}
+
+			now = Clock::now();
+			std::lock_guard<std::mutex> lock(_stats.mutex);
+			std::size_t entry = 0;
+			for (std::size_t owner : pollOwners)
+			{
+				Bot& bot = *bots[owner];
+				bool streamReadable = pollSet[entry++].revents != 0; //errors and hangups show up on the next read
+				bool datagramReadable = false;
+				if (bot.getDatagramSocket() != INVALID_SOCKET_HANDLE) {
+					datagramReadable = pollSet[entry++].revents != 0;
+				}
+				bot.service(now, streamReadable, datagramReadable, _stats);
+			}
+		}
+	}
+
+	float percentile(std::vector<float>& _samples, double _fraction)
+	{
+		if (_samples.empty()) {
+			return 0.f;
+		}
+		std::size_t index = std::min(_samples.size() - 1, static_cast<std::size_t>(_fraction * _samples.size()));
+		std::nth_element(_samples.begin(), _samples.begin() + index, _samples.end());
+		return _samples[index];
+	}
+
+	/// <summary>
+	/// one line for what every bot saw since the last one, rates are per second over the interval
+	/// </summary>
+	void report(BotStats& _total, double _seconds, std::uint64_t _online)
+	{
+		std::cout << "online " << _online
+			<< " connects " << _total.connects
+			<< " failed " << _total.connectFailures
+			<< " dropped " << _total.disconnects
+			<< " snapshots/s " << static_cast<std::uint64_t>(_total.snapshots / _seconds)
+			<< " per bot " << (_online > 0 ? _total.snapshots / _seconds / _online : 0.0)
+			<< " stale " << _total.staleSnapshots
+			<< " in " << static_cast<std::uint64_t>(_total.bytesIn / _seconds) << " B/s"
+			<< " out " << static_cast<std::uint64_t>(_total.bytesOut / _seconds) << " B/s"
+			<< " rtt p50 " << percentile(_total.roundTrips, 0.5)
+			<< " p90 " << percentile(_total.roundTrips, 0.9)
+			<< " p99 " << percentile(_total.roundTrips, 0.99)
+			<< " max " << percentile(_total.roundTrips, 1.0) << " ms" << "\n";
+	}
+}
+
+/// <summary>
+/// headless load generator, many simulated players against one server so its tick cost can be measured under load
+/// </summary>
+/// <returns>success or failure</returns>
+int main(int argc, char* argv[])
+{
+	LoadConfig config;
+	if (!parseArguments(argc, argv, config)) {
+		return 1;
+	}
+	config.threads = std::min(config.threads, config.clients);
+
+	std::signal(SIGINT, onSignal);
+	std::signal(SIGTERM, onSignal);
+
+	if (!initSockets()) {
+		return 1;
+	}
+	std::cout << "Starting " << config.clients << " bots on " << config.threads << " threads against "
+		<< config.bot.host << ":" << config.bot.port << "\n";
+
+	std::atomic<bool> stop = false;
+	std::vector<std::unique_ptr<BotStats>> stats;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < config.threads; ++t) {
+		stats.push_back(std::make_unique<BotStats>());
+		threads.emplace_back(runBots, std::cref(config), t, std::ref(*stats.back()), std::cref(stop));
+	}
+
+	using Clock = Bot::Clock;
+	Clock::time_point start = Clock::now();
+	Clock::time_point lastReport = start;
+	std::uint64_t online = 0;
+	BotStats overall; //whole run, for the summary
+	while (!stopRequested && (config.duration == 0 || Clock::now() - start < std::chrono::seconds(config.duration)))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		Clock::time_point now = Clock::now();
+		if (now - lastReport < std::chrono::seconds(5)) {
+			continue;
+		}
+
+		BotStats interval;
+		for (auto& threadStats : stats) {
+			std::lock_guard<std::mutex> lock(threadStats->mutex);
+			threadStats->drainInto(interval);
+		}
+		online += interval.connects - interval.disconnects;
+		report(interval, std::chrono::duration<double>(now - lastReport).count(), online);
+		interval.drainInto(overall);
+		lastReport = now;
+	}
+
+	stop = true;
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	for (auto& threadStats : stats) {
+		threadStats->drainInto(overall);
+	}
+	std::cout << "Whole run:" << "\n";
+	report(overall, std::chrono::duration<double>(Clock::now() - start).count(), overall.connects - overall.disconnects);
+
+	shutdownSockets();
+	return 0;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include<SFML/Graphics.hpp>
+#include"WorldConstants.h"
 
 const char* const APPLE_SPRITE = "ASSETS\\IMAGES\\Apple.png";
 
@@ -7,5 +8,7 @@ const char* const FONT = "ASSETS\\FONTS\\edge.ttf";
 
 const sf::Color GRAY = sf::Color(21, 21, 21);
 
-const int SCREEN_WIDTH = 1200;
-const int SCREEN_HEIGHT = 700;
\ No newline at end of file
+const float SNAP_DISTANCE = 50.f; //prediction corrections bigger than this are jumped to instead of smoothed
+
+const float INTERPOLATION_DELAY = 0.1f; //seconds remote players are drawn behind the host, covers jitter and a lost snapshot or two
+const float MAX_EXTRAPOLATION = 0.1f; //seconds a remote player keeps moving when snapshots are late
\ No newline at end of file
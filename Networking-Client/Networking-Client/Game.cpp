@@ -1,6 +1,9 @@
 #include "Game.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <format>
 #include <thread>
 
 /// <summary>
@@ -34,8 +37,13 @@ Game::~Game()
 		networkThread.join();
 	}
 
-	closesocket(clientSocket); 
-	WSACleanup();
+	if (clientSocket != INVALID_SOCKET_HANDLE) {
+		closeSocket(clientSocket);
+	}
+	if (datagramSocket != INVALID_SOCKET_HANDLE) {
+		closeSocket(datagramSocket);
+	}
+	shutdownSockets();
 }
 
 
@@ -94,86 +102,128 @@ void Game::processEvents()
 /// <param name="t_deltaTime">time interval per frame</param>
 void Game::update(sf::Time t_deltaTime)
 {
+	serviceDatagrams();
+	interpolateRemotePlayers();
 	if (currentState == GameState::Playing) {
-		handleMovement();
+		handleMovement(t_deltaTime);
 	}
 }
 
 /// <summary>
 /// draw the frame and then switch buffers
+/// players and the pickup keep their shapes in the batches up to date, so however many there are
+/// the world is two draw calls
 /// </summary>
 void Game::render()
 {
 	m_window.clear(sf::Color::Black);
-	for (auto& player : activePlayers) {
-		player->render(m_window);
-	}
+	m_window.draw(bodies);
 	if(currentState == GameState::GameOver)
 	{
 		m_window.draw(gameOverText);
 	}
-	if (currentPlayer) {
-		m_window.draw(currentPlayer->indicator);
-	}
-	if(pickup)
-	{
-		pickup->render(m_window);
-	}
+	m_window.draw(indicators);
 	m_window.display();
 }
 
 
-void Game::handleMovement()
+/// <summary>
+/// moves our player straight away with the same code the host runs and sends the input,
+/// the host position replaces the prediction when it arrives (see reconcile)
+/// inputs go once per host tick whatever the frame rate, since the host applies one a tick
+/// </summary>
+void Game::handleMovement(sf::Time _deltaTime)
 {
-	float dx = 0, dy = 0;
+	int dx = 0, dy = 0;
 	if (m_window.hasFocus()) {
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::W)) dy -=1;
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)) dy+=1;
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) dx -=1;
 		if (sf::Keyboard::isKeyPressed(sf::Keyboard::D)) dx+=1;
 	}
-	if (currentPlayer) {
-		currentPlayer->move(sf::Vector2f(dx, dy));
+
+	std::lock_guard<std::mutex> lock(dataMutex);  //locking to prevent race condition when accessing shared resources
+	if (!currentPlayer || !hasPrediction) {
+		inputTime = 0.f;
+		return; //nothing to move until the host has placed us
 	}
-	//sends data back to serer
-	sendPlayerData(sf::Vector2f(dx,dy));
-}
 
+	float tickLength = 1.f / hostTickRate;
+	inputTime = std::min(inputTime + _deltaTime.asSeconds(), tickLength * 2.f); //a stalled frame is not made up with a burst
+	for (; inputTime >= tickLength; inputTime -= tickLength) {
+		if (dx != 0 || dy != 0) { //standing still is the default, no need to send it
+			PendingInput input{ ++inputSequence, static_cast<std::int8_t>(dx), static_cast<std::int8_t>(dy) };
+			pendingInputs.push_back(input);
+			Simulation::applyMovement(predictedState, dx, dy);
+
+			//sends data back to serer
+			sendPlayerData(input);
+		}
+	}
+
+	predictionError *= 0.85f; //corrections fade over a few frames instead of snapping
+	currentPlayer->updatePlayerPosition(sf::Vector2f(predictedState.x.toFloat(), predictedState.y.toFloat()) + predictionError);
+}
 
-void Game::sendPlayerData(sf::Vector2f vel)
+/// <summary>
+/// sends one input to the host, dataMutex must be held
+/// </summary>
+void Game::sendPlayerData(const PendingInput& _input)
 {
-	std::lock_guard<std::mutex> lock(dataMutex);  //locking to prevent race condition when accessing shared resources
-	PacketData packet;
-	packet.xVel = static_cast<int>(vel.x);
-	packet.yVel = static_cast<int>(vel.y);
+	PlayerInputMessage message;
+	message.inputSequence = _input.sequence;
+	message.viewTick = viewTick;
+	message.xDir = _input.xDir;
+	message.yDir = _input.yDir;
 
+	char buffer[messageSize<PlayerInputMessage>()];
+	encodeMessage(message, outgoingSequence++, buffer);
 
-	if (send(clientSocket, reinterpret_cast<char*>(&packet), sizeof(packet), 0) == SOCKET_ERROR) {
-		std::cerr << "Error sending data: " << WSAGetLastError();
+	if (sendBytes(clientSocket, buffer, sizeof(buffer)) < 0) {
+		std::cerr << "Error sending data: " << lastSocketError();
 	}
 }
 
 /// <summary>
-/// removes a local player from the vector if they have left
+/// says hello over udp until the host echoes it, then reads every datagram waiting
 /// </summary>
-/// <param name="_message"></param>
-void Game::removeLocalPeer(std::string _message)
+void Game::serviceDatagrams()
 {
-	size_t colonPos = _message.find(": ");
+	if (datagramSocket == INVALID_SOCKET_HANDLE || udpToken == 0) {
+		return; //no udp or no token yet, positions arrive over tcp
+	}
 
-	int idToRemove = std::stoi(_message.substr(colonPos + 2));
+	if (!udpBound && udpHelloTimer.getElapsedTime().asSeconds() > 0.25f) { //hellos can get lost too
+		char buffer[messageSize<UdpHelloMessage>()];
+		encodeMessage(UdpHelloMessage{ udpToken }, outgoingSequence++, buffer);
+		sendDatagram(datagramSocket, hostAddress, buffer, sizeof(buffer));
+		udpHelloTimer.restart();
+	}
 
-	auto it = std::remove_if(activePlayers.begin(), activePlayers.end(),
-		[idToRemove](const std::shared_ptr<Player>& player) {
-			return player->localID == idToRemove;
+	char datagram[MAX_DATAGRAM_SIZE];
+	SocketAddress from;
+	int received;
+	while ((received = receiveDatagram(datagramSocket, datagram, sizeof(datagram), from)) > 0) {
+		if (!sameAddress(from, hostAddress)) {
+			continue; //not from our host
+		}
+		forEachMessage(datagram, received, [this](const MessageHeader& _header, const char* _payload) {
+			handleDatagramMessage(_header, _payload);
 		});
+	}
+}
 
-	if (it != activePlayers.end()) {
-		activePlayers.erase(it, activePlayers.end()); // Remove the player(s)
-		std::cout << "Player with ID " << idToRemove << " removed." << "\n";
+/// <summary>
+/// removes a local player from the vector if they have left
+/// </summary>
+/// <param name="_playerID"></param>
+void Game::removeLocalPeer(int _playerID)
+{
+	if (activePlayers.erase(_playerID) != 0) {
+		std::cout << "Player with ID " << _playerID << " removed." << "\n";
 	}
 	else {
-		std::cout << "Player with ID " << idToRemove << " not found." << "\n";
+		std::cout << "Player with ID " << _playerID << " not found." << "\n";
 	}
 }
 
@@ -187,72 +237,24 @@ void Game::networkLoop()
 /// </summary>
 void Game::receivePositions()
 {
+	StreamBuffer stream; //reassembles messages split or merged by tcp
+
 	while (isRunning) {
-		char data[256]; //buffer size
-		int received = recv(clientSocket, data, sizeof(data), 0);
+		int received = receiveBytes(clientSocket, stream.writePointer(), stream.writableBytes());
 
 		if (received > 0) {
-			std::string message(data, received);
-			if(message.starts_with("Remove"))
-			{
-				removeLocalPeer(message);
-			}
-			if(message.starts_with("Invis")) //invisibility color changes
-			{
-				handleInvisState(message);
-			}
-			if (message.starts_with("PickUp")) //pickup locations
-			{
-				handleInvisLocation(message);
-			}
-			if (received == sizeof(int)) { //assign local id
-				localID = *reinterpret_cast<int*>(data);
-				std::cout << "Assigned local ID: " << localID << "\n";
+			stream.commitWrite(received);
+
+			MessageHeader header;
+			const char* payload = nullptr;
+			FrameStatus status;
+			while ((status = stream.nextFrame(header, payload)) == FrameStatus::Complete) { //every whole message this wakeup
+				handleMessage(header, payload);
 			}
-			if (received == sizeof(PacketData)) { //updating player and game 
-				PacketData* packet = reinterpret_cast<PacketData*>(data);
-
-				std::lock_guard<std::mutex> lock(dataMutex); //lock
-
-				if (packet->gameOver) {
-					std::string temp = "Game Over! Red lasted " + packet->timeLasted + " seconds"; //update end game
-					gameOverText.setString(temp);
-					currentState = GameState::GameOver;
-				}
-				if (packet->restart) { //restart game
-					currentState = GameState::Playing;
-					for(auto& player : activePlayers)
-					{
-						if (packet->playerID == player->localID) {
-							player->isIt = packet->isIt;
-							player->setColor();
-						}
-					}
-				}
-
-				if (activePlayers.size() < 3) { //3 player limit
-					auto it = std::find_if(activePlayers.begin(), activePlayers.end(),
-						[packet](const std::shared_ptr<Player>& player) {
-							return player->localID == packet->playerID;
-						});
-
-					if (it == activePlayers.end()) { //doesnt add play if already in local storage based on id
-						activePlayers.push_back(std::make_shared<Player>(packet->playerID, packet->isIt));
-
-						//if the added player is the local player, set it as currentPlayer
-						if (packet->playerID == localID) {
-							currentPlayer = activePlayers.back();
-							currentState = GameState::Playing;
-						}
-					}
-				}
-				for(auto& player : activePlayers)
-				{
-					if(player->localID == packet->playerID)
-					{
-						player->updatePlayerPosition(sf::Vector2f(packet->xVel, packet->yVel));
-					}
-				}
+			if (status == FrameStatus::Malformed) {
+				std::cerr << "Malformed data from host, disconnecting." << "\n";
+				isRunning = false;
+				break;
 			}
 		}
 		else if (received == 0) {
@@ -261,61 +263,262 @@ void Game::receivePositions()
 			break;
 		}
 		else {
-			std::cerr << "Error receiving data: " << WSAGetLastError() << "\n";
+			std::cerr << "Error receiving data: " << lastSocketError() << "\n";
 			isRunning = false;
 			break;
 		}
 	}
 }
 
-void Game::handleInvisState(std::string _message)
+/// <summary>
+/// routes a message to its handler based on the header type
+/// </summary>
+/// <param name="_header">validated header</param>
+/// <param name="_payload">first byte after the header</param>
+void Game::handleMessage(const MessageHeader& _header, const char* _payload)
+{
+	switch (static_cast<MessageType>(_header.type))
+	{
+	case MessageType::AssignID: { //assign local id
+		AssignIDMessage assign = decodePayload<AssignIDMessage>(_payload);
+		localID = assign.playerID;
+		udpToken = assign.udpToken;
+		hostTickRate = assign.tickRate > 0 ? assign.tickRate : 60;
+		std::cout << "Assigned local ID: " << localID << "\n";
+		break;
+	}
+	case MessageType::Snapshot: //world state, over tcp until udp is linked
+		handleSnapshot(_payload, _header.length);
+		break;
+	default:
+		break;
+	}
+}
+
+/// <summary>
+/// handles a message that came over udp, these can arrive late, twice or not at all
+/// </summary>
+/// <param name="_header">validated header</param>
+/// <param name="_payload">first byte after the header</param>
+void Game::handleDatagramMessage(const MessageHeader& _header, const char* _payload)
+{
+	switch (static_cast<MessageType>(_header.type))
+	{
+	case MessageType::UdpHello:
+		if (!udpBound && decodePayload<UdpHelloMessage>(_payload).udpToken == udpToken) {
+			udpBound = true;
+			std::cout << "Udp linked with host" << "\n";
+		}
+		break;
+	case MessageType::Snapshot:
+		handleSnapshot(_payload, _header.length);
+		break;
+	default:
+		break; //everything else is reliable and comes over tcp
+	}
+}
+
+/// <summary>
+/// rebuilds the world from a delta against a snapshot we acked, late or orphaned snapshots are dropped
+/// and the host keeps sending the changes against our last ack until one gets through
+/// </summary>
+/// <param name="_payload">first byte after the header</param>
+/// <param name="_size">payload length from the header</param>
+void Game::handleSnapshot(const char* _payload, std::size_t _size)
 {
-	size_t commaPos = _message.find(','); //find split in data
+	std::lock_guard<std::mutex> lock(dataMutex); //lock
+
+	SnapshotMessage fixed = decodePayload<SnapshotMessage>(_payload);
+	if (!isNewerSequence(fixed.tick, lastSnapshotTick)) {
+		return; //overtaken by something newer
+	}
+	const Snapshot* baseline = snapshots.find(fixed.baselineTick);
+	if (baseline == nullptr || !decodeSnapshotDelta(*baseline, _payload, _size, decodedSnapshot)) {
+		return;
+	}
+
+	acknowledgedInput = fixed.lastInput;
+	snapshotTime = static_cast<double>(decodedSnapshot.tick) / hostTickRate;
+	updateHostClock(snapshotTime);
+	applySnapshot(*snapshots.find(lastSnapshotTick), decodedSnapshot);
 
-	// extract
-	std::string playerIDStr = _message.substr(_message.find(": ") + 2, commaPos - (_message.find(": ") + 2));
-	std::string resetColor = _message.substr(commaPos + 1); 
+	Snapshot& stored = snapshots.store(decodedSnapshot.tick);
+	stored = decodedSnapshot;
+	lastSnapshotTick = decodedSnapshot.tick;
 
-	int playerID = std::stoi(playerIDStr); //convert to integer
-	bool reset = std::stoi(resetColor); //convert to integer
+	sendSnapshotAck(lastSnapshotTick);
+}
 
-	for (auto& player : activePlayers)
+/// <summary>
+/// compares the new snapshot to the one on screen and updates only what changed
+/// </summary>
+void Game::applySnapshot(const Snapshot& _previous, const Snapshot& _next)
+{
+	//both are sorted by slot, walk them together to find joins, leaves and changes
+	std::size_t p = 0;
+	for (const SnapshotPlayer& player : _next.players)
 	{
-		if (player->localID == playerID && !reset)
-		{
-			if (player->localID == currentPlayer->localID)
-			{
-				player->invisiblePowerUp(true);
-				pickup.reset();
-			}
-			else
-			{
-				player->invisiblePowerUp(false);
-				pickup.reset();
-			}
+		while (p < _previous.players.size() && SlotID::index(_previous.players[p].id) < SlotID::index(player.id)) {
+			removeLocalPeer(_previous.players[p++].id); //player has left
 		}
-		else
-		{
-			player->setColor();
-			if(!reset)
-			{
-				pickup.reset();
+		if (p < _previous.players.size() && SlotID::index(_previous.players[p].id) == SlotID::index(player.id)) {
+			const SnapshotPlayer& previous = _previous.players[p++];
+			if (previous.id == player.id) {
+				applyPlayer(&previous, player);
+				continue;
 			}
+			removeLocalPeer(previous.id); //left and someone new took the slot
+			applyPlayer(nullptr, player);
+		}
+		else {
+			applyPlayer(nullptr, player);
+		}
+	}
+	while (p < _previous.players.size()) {
+		removeLocalPeer(_previous.players[p++].id);
+	}
+
+	if (!_next.pickUpActive) {
+		pickup.reset(); //picked up or the round ended
+	}
+	else if (!_previous.pickUpActive || _previous.pickUpX != _next.pickUpX || _previous.pickUpY != _next.pickUpY) {
+		sf::Vector2f position(POSITION_X.dequantize(_next.pickUpX), POSITION_Y.dequantize(_next.pickUpY));
+		pickup = std::make_unique<InvisibilityPickUp>(position, bodies); //make pickup
+	}
+
+	if (_next.gameOver && !_previous.gameOver) {
+		float survivalTime = _next.survivalMillis / 1000.f;
+		gameOverText.setString("Game Over! Red lasted " + std::format("{:.2f}", survivalTime) + " seconds"); //update end game
+		currentState = GameState::GameOver;
+	}
+	else if (!_next.gameOver && currentPlayer) {
+		currentState = GameState::Playing; //restarted
+	}
+}
+
+/// <summary>
+/// adds a player we have not seen, moves it, and updates its colour if it was tagged or went invisible
+/// </summary>
+void Game::applyPlayer(const SnapshotPlayer* _previous, const SnapshotPlayer& _next)
+{
+	std::shared_ptr<Player>& entry = activePlayers[_next.id];
+	if (!entry) { //doesnt add play if already in local storage based on id
+		entry = std::make_shared<Player>(_next.id, _next.isIt, bodies, indicators);
+
+		//if the added player is the local player, set it as currentPlayer
+		if (_next.id == localID) {
+			currentPlayer = entry;
+			currentPlayer->showIndicator();
+		}
+	}
+	Player& player = *entry;
+
+	if (_next.id == localID) {
+		reconcile(_next); //every snapshot, acks move on even when the position does not
+	}
+	else {
+		sf::Vector2f position(POSITION_X.dequantize(_next.x), POSITION_Y.dequantize(_next.y));
+		player.positions.push(snapshotTime, position); //every snapshot, a still player needs samples too
+		if (_previous == nullptr) {
+			player.updatePlayerPosition(position); //drawn somewhere sensible until the buffer catches up
+		}
+	}
+	if (_previous == nullptr || _previous->isIt != _next.isIt || _previous->invisible != _next.invisible) {
+		player.isIt = _next.isIt;
+		player.setColor();
+		if (_next.invisible) {
+			player.invisiblePowerUp(_next.id == localID); //we still see ourselves faintly
+		}
+	}
+}
+
+/// <summary>
+/// rebuilds the prediction from the host position by replaying every input it has not applied yet,
+/// whatever small difference is left is faded out rather than snapped to
+/// </summary>
+void Game::reconcile(const SnapshotPlayer& _authoritative)
+{
+	while (!pendingInputs.empty() && !isNewerSequence(pendingInputs.front().sequence, acknowledgedInput)) {
+		pendingInputs.pop_front(); //already in the host position
+	}
+
+	sf::Vector2f before(predictedState.x.toFloat(), predictedState.y.toFloat());
+
+	predictedState.id = _authoritative.id;
+	predictedState.x = Fixed::fromFloat(POSITION_X.dequantize(_authoritative.x));
+	predictedState.y = Fixed::fromFloat(POSITION_Y.dequantize(_authoritative.y));
+	for (const PendingInput& input : pendingInputs) {
+		Simulation::applyMovement(predictedState, input.xDir, input.yDir);
+	}
+
+	sf::Vector2f after(predictedState.x.toFloat(), predictedState.y.toFloat());
+	sf::Vector2f correction = before - after;
+	if (!hasPrediction || std::abs(correction.x) > SNAP_DISTANCE || std::abs(correction.y) > SNAP_DISTANCE) {
+		predictionError = sf::Vector2f(); //first placement, a wrap or a restart, jump straight there
+	}
+	else {
+		predictionError += correction; //keep drawing where we were and let it fade
+	}
+	hasPrediction = true;
+
+	currentPlayer->updatePlayerPosition(after + predictionError);
+}
+
+/// <summary>
+/// the least delayed snapshot gives the best guess of host time, so jump forward to any
+/// that arrives early and only drift back slowly when they arrive late
+/// </summary>
+void Game::updateHostClock(double _snapshotTime)
+{
+	double offset = _snapshotTime - hostClock.getElapsedTime().asSeconds();
+	if (!hasHostTime || offset > hostTimeOffset || hostTimeOffset - offset > 0.25) {
+		hostTimeOffset = offset;
+	}
+	else {
+		hostTimeOffset += (offset - hostTimeOffset) * 0.05;
+	}
+	hasHostTime = true;
+}
+
+/// <summary>
+/// moves every remote player to where it was INTERPOLATION_DELAY ago in host time
+/// </summary>
+void Game::interpolateRemotePlayers()
+{
+	std::lock_guard<std::mutex> lock(dataMutex); //lock
+	if (!hasHostTime) {
+		return;
+	}
+
+	double renderTime = hostClock.getElapsedTime().asSeconds() + hostTimeOffset - INTERPOLATION_DELAY;
+	viewTick = renderTime > 0.0 ? static_cast<std::uint32_t>(std::lround(renderTime * hostTickRate)) : 0;
+	for (auto& [id, player] : activePlayers)
+	{
+		sf::Vector2f position;
+		if (id != localID && player->positions.sample(renderTime, MAX_EXTRAPOLATION, position)) {
+			player->updatePlayerPosition(position);
 		}
 	}
 }
 
-void Game::handleInvisLocation(std::string _message)
+/// <summary>
+/// tells the host which snapshot we now have so it can delta against it, over udp once linked
+/// </summary>
+void Game::sendSnapshotAck(std::uint32_t _tick)
 {
-	size_t commaPos = _message.find(','); //splitter
+	SnapshotAckMessage ack;
+	ack.udpToken = udpToken;
+	ack.tick = _tick;
 
-	//extract
-	std::string xStr = _message.substr(_message.find(": ") + 2, commaPos - (_message.find(": ") + 2)); //x value
-	std::string yStr = _message.substr(commaPos + 1); //y value after the comma
-	int xPos = std::stoi(xStr); //convert to integer
-	int yPos = std::stoi(yStr); //convert to integer
+	char buffer[messageSize<SnapshotAckMessage>()];
+	encodeMessage(ack, outgoingSequence++, buffer);
 
-	pickup = std::make_unique<InvisibilityPickUp>(sf::Vector2f(xPos, yPos)); //make pickup
+	if (udpBound) {
+		sendDatagram(datagramSocket, hostAddress, buffer, sizeof(buffer));
+	}
+	else if (sendBytes(clientSocket, buffer, sizeof(buffer)) < 0) {
+		std::cerr << "Error sending data: " << lastSocketError();
+	}
 }
 
 /// <summary>
@@ -326,32 +529,24 @@ void Game::handleInvisLocation(std::string _message)
 /// <returns></returns>
 bool Game::connectToHost(const std::string& host, unsigned short port)
 {
-	WSADATA wsaData;
-	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
-		std::cerr << "WSAStartup failed: " << WSAGetLastError() << "\n";
+	if (!initSockets()) {
 		return false;
 	}
 
-	clientSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-	if (clientSocket == INVALID_SOCKET) {
-		std::cerr << "Error creating socket: " << "\n";
-		WSACleanup();
+	clientSocket = connectTo(host, port);
+	if (clientSocket == INVALID_SOCKET_HANDLE) {
+		shutdownSockets();
 		return false;
 	}
 
-	sockaddr_in serverAddr;
-	serverAddr.sin_family = AF_INET;
-	inet_pton(AF_INET, host.c_str(), &serverAddr.sin_addr);
-	serverAddr.sin_port = htons(port);
+	std::cout << "Connected to host: " << host << ":" << port << "\n";
 
-	if (connect(clientSocket, reinterpret_cast<sockaddr*>(&serverAddr), sizeof(serverAddr)) == SOCKET_ERROR) {
-		std::cerr << "Failed to connect to host: " << WSAGetLastError() << "\n";
-		closesocket(clientSocket);
-		WSACleanup();
-		return false;
+	if (resolveAddress(host, port, hostAddress)) {
+		datagramSocket = openDatagramSocket(0); //any free port, the host learns it from our hello
+	}
+	if (datagramSocket == INVALID_SOCKET_HANDLE) {
+		std::cout << "Udp unavailable, positions will come over tcp" << "\n";
 	}
-
-	std::cout << "Connected to host: " << host << ":" << port << "\n";
 	return true;
 }
 
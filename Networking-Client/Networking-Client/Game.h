@@ -2,14 +2,27 @@
 #define GAME_HPP
 #include <SFML/Graphics.hpp>
 #include<SFML/Audio.hpp>
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#pragma comment(lib, "Ws2_32.lib")
+#include <deque>
 #include <iostream>
 #include <mutex>
+#include <unordered_map>
 #include"InvisibilityPickUp.h"
 #include"Constants.h"
 #include"Player.h"
+#include"ShapeBatch.h"
+#include"Protocol.h"
+#include"Simulation.h"
+#include"Snapshot.h"
+#include"Socket.h"
+#include"StreamBuffer.h"
+
+/// an input sent to the host that has not shown up in a snapshot yet
+struct PendingInput
+{
+	std::uint32_t sequence;
+	std::int8_t xDir;
+	std::int8_t yDir;
+};
 
 enum class GameState {
 	Wait,
@@ -17,18 +30,6 @@ enum class GameState {
 	GameOver
 };
 
-#pragma pack(push, 1)
-struct PacketData {
-	std::string timeLasted;
-	bool gameOver;
-	bool restart;
-	bool isIt;
-	int playerID;
-	int xVel;
-	int yVel;
-};
-#pragma pack(pop)
-
 class Game
 {
 public:
@@ -46,17 +47,26 @@ private:
 	void update(sf::Time t_deltaTime);
 	void render();
 
-	void handleMovement();
+	void handleMovement(sf::Time _deltaTime); //one input per host tick, the host moves a player once a tick
+	void serviceDatagrams(); //links the udp channel then drains it, never blocks
 
-	void sendPlayerData(sf::Vector2f vel);
+	void sendPlayerData(const PendingInput& _input);
+	void reconcile(const SnapshotPlayer& _authoritative); //host position plus every input it has not applied yet
 
-	void removeLocalPeer(std::string _message); //removes a player  that has left from local
+	void removeLocalPeer(int _playerID); //removes a player  that has left from local
 
 	void networkLoop();
 	void receivePositions();
+	void handleMessage(const MessageHeader& _header, const char* _payload); //dispatches one decoded message
+	void handleDatagramMessage(const MessageHeader& _header, const char* _payload); //snapshots and the hello echo
 
-	void handleInvisState(std::string _message);
-	void handleInvisLocation(std::string _message);
+	void handleSnapshot(const char* _payload, std::size_t _size); //rebuilds the world from a delta and acks it
+	void applySnapshot(const Snapshot& _previous, const Snapshot& _next); //turns what changed into visuals
+	void applyPlayer(const SnapshotPlayer* _previous, const SnapshotPlayer& _next); //_previous is nullptr for a new player
+	void sendSnapshotAck(std::uint32_t _tick);
+
+	void updateHostClock(double _snapshotTime); //keeps an estimate of host time from snapshot arrivals
+	void interpolateRemotePlayers(); //draws remote players INTERPOLATION_DELAY behind the host
 
 	GameState currentState = GameState::Wait;
 
@@ -66,17 +76,47 @@ private:
 	std::thread networkThread;
 	std::mutex dataMutex;
 
-	SOCKET clientSocket; //tcp socket local
+	SocketHandle clientSocket = INVALID_SOCKET_HANDLE; //tcp socket local
+	SocketHandle datagramSocket = INVALID_SOCKET_HANDLE; //udp socket for positions
+	SocketAddress hostAddress{};
+
+	std::atomic<std::uint32_t> udpToken = 0; //from AssignID, 0 until then
+	std::atomic<bool> udpBound = false; //host echoed our hello
+	sf::Clock udpHelloTimer;
+
+	SnapshotHistory snapshots; //baselines the host may send deltas against
+	Snapshot decodedSnapshot; //reused for every snapshot received
+	std::uint32_t lastSnapshotTick = 0; //newest applied, older snapshots are dropped
+
+	std::deque<PendingInput> pendingInputs; //predicted locally, waiting for the host to apply them
+	std::uint32_t inputSequence = 0;
+	std::uint32_t acknowledgedInput = 0; //newest input in the last snapshot
+	PlayerState predictedState; //where the host will have us once it applies pendingInputs
+	bool hasPrediction = false;
+	sf::Vector2f predictionError; //drawn offset left by a correction, fades to nothing
+	float inputTime = 0.f; //seconds since the last input went, inputs go at the host tick rate
+
+	std::atomic<int> hostTickRate = 60; //from AssignID
+	sf::Clock hostClock;
+	double hostTimeOffset = 0.0; //host time minus hostClock time
+	bool hasHostTime = false;
+	double snapshotTime = 0.0; //host time of the snapshot being applied
+	std::uint32_t viewTick = 0; //host tick remote players are drawn at, lets the host check our tags against what we saw
 
 	int localID = 2;
 
+	std::atomic<std::uint32_t> outgoingSequence = 0; //sequence stamped on every sent message, both threads send
+
 	std::atomic<bool> isRunning = false;
 
+	ShapeBatch bodies = ShapeBatch::circles(30); //players and the pickup, before anything that holds shapes in them
+	ShapeBatch indicators = ShapeBatch::rectangles();
+
 	std::shared_ptr<Player> currentPlayer;
 
 	std::unique_ptr<InvisibilityPickUp> pickup;
 
-	std::vector<std::shared_ptr<Player>> activePlayers;
+	std::unordered_map<int, std::shared_ptr<Player>> activePlayers; //by id
 
 	sf::RenderWindow m_window; // main SFML window
 };
@@ -0,0 +1,63 @@
+#include "InterpolationBuffer.h"
+#include "Constants.h"
+#include <algorithm>
+#include <cmath>
+
+void InterpolationBuffer::push(double _time, sf::Vector2f _position)
+{
+	if (count > 0 && _time <= at(0).time) {
+		return; //late or repeated
+	}
+	newest = (newest + 1) % samples.size();
+	samples[newest] = { _time, _position };
+	if (count < samples.size()) {
+		++count;
+	}
+}
+
+bool InterpolationBuffer::sample(double _time, float _maxExtrapolation, sf::Vector2f& _position) const
+{
+	if (count == 0) {
+		return false;
+	}
+
+	const Sample& latest = at(0);
+	if (_time >= latest.time) { //nothing newer has arrived, keep going the way it was going
+		_position = latest.position;
+		if (count > 1) {
+			const Sample& previous = at(1);
+			sf::Vector2f change = latest.position - previous.position;
+			if (std::abs(change.x) <= SNAP_DISTANCE && std::abs(change.y) <= SNAP_DISTANCE) {
+				double ahead = std::min(_time - latest.time, static_cast<double>(_maxExtrapolation));
+				float t = static_cast<float>(ahead / (latest.time - previous.time));
+				_position += change * t;
+			}
+		}
+		return true;
+	}
+
+	for (std::size_t age = 1; age < count; ++age) //newest first, the delay keeps the pair near the front
+	{
+		const Sample& before = at(age);
+		if (before.time > _time) {
+			continue;
+		}
+		const Sample& after = at(age - 1);
+		sf::Vector2f change = after.position - before.position;
+		if (std::abs(change.x) > SNAP_DISTANCE || std::abs(change.y) > SNAP_DISTANCE) {
+			_position = before.position; //wrapped or restarted, sliding across the screen would look wrong
+			return true;
+		}
+		float t = static_cast<float>((_time - before.time) / (after.time - before.time));
+		_position = before.position + change * t;
+		return true;
+	}
+
+	_position = at(count - 1).position; //older than anything we have
+	return true;
+}
+
+const InterpolationBuffer::Sample& InterpolationBuffer::at(std::size_t _age) const
+{
+	return samples[(newest + samples.size() - _age) % samples.size()];
+}
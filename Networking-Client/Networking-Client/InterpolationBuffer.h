@@ -0,0 +1,37 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstddef>
+
+/// <summary>
+/// recent host positions of one remote player stamped with host time
+/// remote players are drawn a little in the past so there are nearly always two samples to blend between,
+/// when there are not the last movement is carried on for a short while
+/// </summary>
+class InterpolationBuffer
+{
+public:
+	void push(double _time, sf::Vector2f _position); //older than the newest sample is ignored
+
+	/// <summary>
+	/// position at _time, blended between the samples either side of it
+	/// </summary>
+	/// <param name="_maxExtrapolation">seconds past the newest sample to keep moving before stopping</param>
+	/// <returns>false if there are no samples yet</returns>
+	bool sample(double _time, float _maxExtrapolation, sf::Vector2f& _position) const;
+
+	void clear() { count = 0; }
+
+private:
+	struct Sample
+	{
+		double time;
+		sf::Vector2f position;
+	};
+
+	const Sample& at(std::size_t _age) const; //0 is the newest
+
+	std::array<Sample, 32> samples{}; //half a second at 60 ticks, far more than the delay needs
+	std::size_t newest = 0;
+	std::size_t count = 0;
+};
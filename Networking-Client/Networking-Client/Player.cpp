@@ -1,16 +1,21 @@
 #include "Player.h"
 
-void Player::render(sf::RenderWindow& _window)
+Player::~Player()
 {
-	_window.draw(playerShape);
+	bodies.remove(body);
+	if (indicator != ShapeBatch::NONE) {
+		indicators.remove(indicator);
+	}
 }
 
-void Player::move(sf::Vector2f _vel)
+void Player::updatePlayerPosition(sf::Vector2f _playerPos)
 {
-    sf::Vector2f newPos = playerShape.getPosition() + _vel * 3.f;
-    playerShape.setPosition(newPos);
+	position = _playerPos;
+	bodies.setPosition(body, _playerPos);
 
-	indicator.setPosition(sf::Vector2f(playerShape.getPosition().x, playerShape.getPosition().y - 40));
+	if (indicator != ShapeBatch::NONE) {
+		indicators.setPosition(indicator, sf::Vector2f(_playerPos.x, _playerPos.y - 40)); //indicator follows the predicted position
+	}
 }
 
 void Player::invisiblePowerUp(bool _currentPlayer)
@@ -19,16 +24,16 @@ void Player::invisiblePowerUp(bool _currentPlayer)
 	{
 		if (currentColor == sf::Color::Green)
 		{
-			playerShape.setFillColor(sf::Color(0, 255, 0, 100)); //alpha lower to indicate invis
+			bodies.setColor(body, sf::Color(0, 255, 0, 100)); //alpha lower to indicate invis
 		}
 		else
 		{
-			playerShape.setFillColor(sf::Color(155, 0, 0, 100)); //alpha lower to indicate invis
+			bodies.setColor(body, sf::Color(155, 0, 0, 100)); //alpha lower to indicate invis
 		}
 	}
 	else
 	{
-		playerShape.setFillColor(sf::Color::Transparent); //if not current player make invisible
+		bodies.setColor(body, sf::Color::Transparent); //if not current player make invisible
 	}
 }
 
@@ -41,17 +46,23 @@ void Player::setColor()
 	{
 		currentColor = sf::Color::Red;
 	}
-	playerShape.setFillColor(currentColor);
-	indicator.setFillColor(currentColor);
+	bodies.setColor(body, currentColor);
+	if (indicator != ShapeBatch::NONE) {
+		indicators.setColor(indicator, currentColor);
+	}
 }
 
-void Player::initShape()
+void Player::showIndicator()
 {
-	playerShape.setRadius(15);
-	playerShape.setOrigin(15, 15);
+	if (indicator == ShapeBatch::NONE) {
+		indicator = indicators.add(sf::Vector2f(5, 20), sf::Vector2f(2, 10), currentColor);
+		indicators.setPosition(indicator, sf::Vector2f(position.x, position.y - 40));
+	}
+}
 
-	indicator.setSize(sf::Vector2f(5, 20));
-	indicator.setOrigin(2, 10);
+void Player::initShape()
+{
+	body = bodies.add(sf::Vector2f(15, 15), sf::Vector2f(), sf::Color::Green); //radius 15 around the position
 
 	setColor();
 }
@@ -1,28 +1,36 @@
 #pragma once
 #include<SFML/Graphics.hpp>
+#include"InterpolationBuffer.h"
+#include"ShapeBatch.h"
 
 class Player
 {
 public:
-	Player(int _id, bool _isIt) : localID(_id), isIt(_isIt) { initShape(); }
+	Player(int _id, bool _isIt, ShapeBatch& _bodies, ShapeBatch& _indicators) : localID(_id), isIt(_isIt), bodies(_bodies), indicators(_indicators) { initShape(); }
+	~Player();
 
-	void render(sf::RenderWindow& _window);
-	void move(sf::Vector2f _vel);
-	void updatePlayerPosition(sf::Vector2f _playerPos) { playerShape.setPosition(_playerPos); }
+	Player(const Player&) = delete;
+	Player& operator=(const Player&) = delete;
+
+	void updatePlayerPosition(sf::Vector2f _playerPos);
 
 	void invisiblePowerUp(bool _currentPlayer);
 
-	sf::Vector2f getPosition() const { return playerShape.getPosition(); }
+	sf::Vector2f getPosition() const { return position; }
 
 	void setColor();
+	void showIndicator(); //only the local player has one
 
 	int localID = 0;
 	bool isIt = false;
-	sf::RectangleShape indicator;
 	sf::Color currentColor;
+	InterpolationBuffer positions; //host positions for remote players, drawn a little behind
 private:
 	void initShape();
-	sf::CircleShape playerShape;
+	ShapeBatch& bodies; //drawn by the game, we only keep our shapes in them up to date
+	ShapeBatch& indicators;
+	int body = ShapeBatch::NONE;
+	int indicator = ShapeBatch::NONE;
+	sf::Vector2f position;
 	
 };
-
@@ -0,0 +1,44 @@
+#pragma once
+#include<SFML/Graphics.hpp>
+#include<vector>
+
+/// <summary>
+/// every shape with the same outline kept in one triangle list, so however many there are they take one draw call
+/// each shape owns a fixed run of vertices, moving or recolouring it rewrites only that run,
+/// and a removed shape is folded to a point until its run is handed out again
+/// </summary>
+class ShapeBatch : public sf::Drawable
+{
+public:
+	static const int NONE = -1;
+
+	static ShapeBatch circles(std::size_t _points); //size is the radius, centred on the position
+	static ShapeBatch rectangles(); //size is the width and height, from the position less the origin
+
+	int add(sf::Vector2f _size, sf::Vector2f _origin, sf::Color _color); //at 0,0 until moved
+	void remove(int _shape);
+
+	void setPosition(int _shape, sf::Vector2f _position);
+	void setColor(int _shape, sf::Color _color);
+
+	std::size_t getCount() const { return shapes.size() - freeShapes.size(); }
+
+private:
+	explicit ShapeBatch(std::vector<sf::Vector2f> _outline) : outline(std::move(_outline)) {}
+
+	void draw(sf::RenderTarget& _target, sf::RenderStates _states) const override;
+	void place(int _shape); //writes the positions of one shape's vertices
+
+	struct Shape
+	{
+		sf::Vector2f position;
+		sf::Vector2f size;
+		sf::Vector2f origin;
+		sf::Color color;
+	};
+
+	std::vector<sf::Vector2f> outline; //triangle list of one shape at unit size
+	std::vector<Shape> shapes; //shape i owns the vertices from i * outline.size()
+	std::vector<int> freeShapes;
+	sf::VertexArray vertices{ sf::Triangles };
+};
@@ -13,17 +13,21 @@
 #endif 
 
 
+#include <cstdlib>
+#include <string>
 #include "Game.h"
 
 /// <summary>
-/// main enrtry point
+/// main enrtry point, optionally takes the host and port, e.g. a Networking-Proxy in front of the host
 /// </summary>
 /// <returns>success or failure</returns>
-int main()
+int main(int argc, char* argv[])
 {
 	srand(time(NULL)); // SET TIME SEED
+	std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+	unsigned short port = argc > 2 ? static_cast<unsigned short>(std::atoi(argv[2])) : 53000;
 	Game game;
-	if(game.connectToHost("127.0.0.1", 53000))
+	if(game.connectToHost(host, port))
 	{
 		game.run();
 	}
@@ -0,0 +1,77 @@
+#include "LinkModel.h"
+#include <algorithm>
+
+namespace
+{
+	const std::chrono::seconds LINK_BUFFER{ 1 }; //longest a datagram waits behind the bandwidth cap before it is dropped
+	const std::chrono::milliseconds MIN_RETRANSMIT{ 200 }; //linux never waits less than this to resend
+}
+
+LinkModel::LinkModel(const LinkProfile& _profile, std::uint32_t _seed) :
+	profile(_profile),
+	random(_seed)
+{
+}
+
+LinkFate LinkModel::scheduleDatagram(Clock::time_point _now, std::size_t _size, Clock::time_point& _deliverAt)
+{
+	if (roll(profile.lossPercent)) {
+		return LinkFate::Lost; //lost before it costs any bandwidth, close enough
+	}
+	if (profile.bandwidthKbps > 0.0 && linkFree - _now > LINK_BUFFER) {
+		return LinkFate::Overflow; //the queue in front of the cap is full
+	}
+
+	_deliverAt = _now + transmit(_now, _size) + propagation();
+	if (roll(profile.reorderPercent)) {
+		//held for another trip or so, enough for the next few to overtake it
+		std::chrono::duration<double, std::milli> hold(std::max(10.0, profile.latencyMs + profile.jitterMs));
+		_deliverAt += std::chrono::duration_cast<Clock::duration>(hold);
+		return LinkFate::Reordered;
+	}
+	return LinkFate::Delivered;
+}
+
+LinkFate LinkModel::scheduleStream(Clock::time_point _now, std::size_t _size, Clock::time_point& _deliverAt)
+{
+	_deliverAt = _now + transmit(_now, _size) + propagation();
+	if (roll(profile.lossPercent)) {
+		std::chrono::duration<double, std::milli> roundTrip(2.0 * (profile.latencyMs + profile.jitterMs));
+		_deliverAt += std::max(std::chrono::duration_cast<Clock::duration>(roundTrip), Clock::duration(MIN_RETRANSMIT));
+		return LinkFate::Lost;
+	}
+	return LinkFate::Delivered;
+}
+
+/// <summary>
+/// the link sends one packet at a time at the capped rate, so a packet waits for everything ahead of it
+/// </summary>
+LinkModel::Clock::duration LinkModel::transmit(Clock::time_point _now, std::size_t _size)
+{
+	if (profile.bandwidthKbps <= 0.0) {
+		return Clock::duration::zero();
+	}
+	linkFree = std::max(linkFree, _now);
+	std::chrono::duration<double> sending(_size * 8.0 / (profile.bandwidthKbps * 1000.0));
+	linkFree += std::chrono::duration_cast<Clock::duration>(sending);
+	return linkFree - _now;
+}
+
+LinkModel::Clock::duration LinkModel::propagation()
+{
+	double delay = profile.latencyMs;
+	if (profile.jitterMs > 0.0) {
+		std::uniform_real_distribution<double> jitter(-profile.jitterMs, profile.jitterMs);
+		delay += jitter(random);
+	}
+	return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(std::max(0.0, delay)));
+}
+
+bool LinkModel::roll(double _percent)
+{
+	if (_percent <= 0.0) {
+		return false; //no draw, so turning one effect off does not change the others
+	}
+	std::uniform_real_distribution<double> chance(0.0, 100.0);
+	return chance(random) < _percent;
+}
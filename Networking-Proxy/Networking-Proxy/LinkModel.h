@@ -0,0 +1,54 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+/// how bad one direction of the link is, everything off is a perfect link
+struct LinkProfile
+{
+	double latencyMs = 0.0; //one way
+	double jitterMs = 0.0; //each packet is delayed up to this much more or less than the latency
+	double lossPercent = 0.0;
+	double reorderPercent = 0.0; //datagrams held back long enough for later ones to overtake them
+	double bandwidthKbps = 0.0; //0 is unlimited
+};
+
+enum class LinkFate
+{
+	Delivered,
+	Lost, //dropped on the way, or retransmitted for a stream
+	Overflow, //queued longer than the link buffer allows behind the bandwidth cap
+	Reordered //delivered, but held back past packets sent after it
+};
+
+/// <summary>
+/// one direction of an emulated link, decides when each packet arrives or whether it does at all
+/// every decision comes from its own seeded generator so the same traffic gets the same treatment every run
+/// </summary>
+class LinkModel
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	LinkModel(const LinkProfile& _profile, std::uint32_t _seed);
+
+	/// <summary>
+	/// a datagram can be lost, overtaken or dropped when the bandwidth queue is too long
+	/// </summary>
+	LinkFate scheduleDatagram(Clock::time_point _now, std::size_t _size, Clock::time_point& _deliverAt);
+
+	/// <summary>
+	/// a stream chunk always arrives, a loss costs it a retransmit timeout instead,
+	/// the caller keeps each stream in order so the chunks behind it wait too
+	/// </summary>
+	LinkFate scheduleStream(Clock::time_point _now, std::size_t _size, Clock::time_point& _deliverAt);
+
+private:
+	Clock::duration transmit(Clock::time_point _now, std::size_t _size); //wait for the bandwidth cap, 0 when uncapped
+	Clock::duration propagation(); //latency with jitter
+	bool roll(double _percent);
+
+	LinkProfile profile;
+	std::mt19937 random;
+	Clock::time_point linkFree{}; //when the bandwidth cap has sent everything queued so far
+};
@@ -0,0 +1,384 @@
+#include "Proxy.h"
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	const std::size_t READ_CHUNK = 16 * 1024; //one stream read, each read is one segment on the emulated link
+	const std::chrono::seconds SESSION_TIMEOUT{ 30 }; //udp senders quiet this long are forgotten
+	const char* DIRECTION_NAMES[2] = { "up", "down" };
+
+	const char* fateName(LinkFate _fate)
+	{
+		switch (_fate)
+		{
+		case LinkFate::Lost: return "lost";
+		case LinkFate::Overflow: return "overflow";
+		case LinkFate::Reordered: return "reordered";
+		default: return "delivered";
+		}
+	}
+}
+
+Proxy::Proxy(const ProxyConfig& _config) :
+	config(_config),
+	links{ LinkModel(_config.up, _config.seed * 2 + 1), LinkModel(_config.down, _config.seed * 2 + 2) } //a stream each, so one direction does not shift the others draws
+{
+}
+
+Proxy::~Proxy()
+{
+	for (auto& [id, pair] : streams) {
+		closeSocket(pair.client);
+		closeSocket(pair.host);
+	}
+	for (auto& [id, session] : sessions) {
+		closeSocket(session.upstream);
+	}
+	if (listener != INVALID_SOCKET_HANDLE) {
+		closeSocket(listener);
+	}
+	if (datagramSocket != INVALID_SOCKET_HANDLE) {
+		closeSocket(datagramSocket);
+	}
+}
+
+bool Proxy::start()
+{
+	if (!resolveAddress(config.targetHost, config.targetPort, target)) {
+		std::cerr << "Target must be a dotted ipv4 address: " << config.targetHost << "\n";
+		return false;
+	}
+	listener = openListener(config.listenPort);
+	if (listener == INVALID_SOCKET_HANDLE) {
+		return false;
+	}
+	datagramSocket = openDatagramSocket(config.listenPort);
+	if (datagramSocket == INVALID_SOCKET_HANDLE) {
+		return false;
+	}
+
+	if (!config.tracePath.empty()) {
+		trace.open(config.tracePath);
+		if (!trace) {
+			std::cerr << "Could not open " << config.tracePath << "\n";
+			return false;
+		}
+		trace << "ms,direction,protocol,bytes,delay_ms,fate" << "\n";
+	}
+	started = Clock::now();
+	nextExpiry = started + SESSION_TIMEOUT;
+	return true;
+}
+
+/// <summary>
+/// waits until traffic arrives or the next queued packet is due, whichever is first
+/// </summary>
+void Proxy::poll(int _maxWaitMs)
+{
+	Clock::time_point now = Clock::now();
+	int timeout = _maxWaitMs;
+	if (!deliveries.empty()) {
+		auto untilDue = std::chrono::duration_cast<std::chrono::milliseconds>(deliveries.top().at - now).count();
+		timeout = static_cast<int>(std::clamp<long long>(untilDue, 0, _maxWaitMs));
+	}
+
+	pollSet.clear();
+	pollEntries.clear();
+	pollSet.push_back({ listener, POLLIN, 0 });
+	pollSet.push_back({ datagramSocket, POLLIN, 0 });
+	for (auto& [id, pair] : streams) {
+		if (!pair.finished[UP]) {
+			pollSet.push_back({ pair.client, POLLIN, 0 });
+			pollEntries.push_back({ id, UP, false });
+		}
+		if (!pair.finished[DOWN]) {
+			pollSet.push_back({ pair.host, POLLIN, 0 });
+			pollEntries.push_back({ id, DOWN, false });
+		}
+	}
+	for (auto& [id, session] : sessions) {
+		pollSet.push_back({ session.upstream, POLLIN, 0 });
+		pollEntries.push_back({ id, DOWN, true });
+	}
+
+#ifdef _WIN32
+	WSAPoll(pollSet.data(), static_cast<ULONG>(pollSet.size()), timeout);
+#else
+	::poll(pollSet.data(), pollSet.size(), timeout);
+#endif
+
+	if (pollSet[0].revents != 0) {
+		acceptClients();
+	}
+	if (pollSet[1].revents != 0) {
+		readClientDatagrams();
+	}
+	for (std::size_t i = 0; i < pollEntries.size(); ++i) {
+		if (pollSet[i + 2].revents == 0) {
+			continue;
+		}
+		const PollEntry& entry = pollEntries[i];
+		if (entry.session) {
+			readHostDatagrams(entry.owner);
+		}
+		else {
+			readStream(entry.owner, entry.direction); //may close the pair, its other entry then misses
+		}
+	}
+
+	now = Clock::now();
+	deliverDue(now);
+	if (now >= nextExpiry) {
+		expireSessions(now);
+		nextExpiry = now + SESSION_TIMEOUT;
+	}
+}
+
+void Proxy::report(std::ostream& _out)
+{
+	for (int direction : { UP, DOWN }) {
+		DirectionStats& totals = stats[direction];
+		std::uint64_t arrived = totals.packets - totals.lost - totals.overflow;
+		_out << DIRECTION_NAMES[direction]
+			<< " packets " << totals.packets
+			<< " bytes " << totals.bytes
+			<< " lost " << totals.lost
+			<< " overflow " << totals.overflow
+			<< " reordered " << totals.reordered
+			<< " retransmitted " << totals.retransmitted
+			<< " delay avg " << (arrived > 0 ? totals.delaySumMs / arrived : 0.0)
+			<< " max " << totals.delayMaxMs << " ms" << "\n";
+		totals = DirectionStats();
+	}
+	_out << "streams " << streams.size() << " udp sessions " << sessions.size() << " queued " << deliveries.size() << "\n";
+}
+
+/// <summary>
+/// every client connection gets a fresh connection to the host, a client the host refuses is closed straight away
+/// </summary>
+void Proxy::acceptClients()
+{
+	SocketHandle client = accept(listener, nullptr, nullptr);
+	if (client == INVALID_SOCKET_HANDLE) {
+		return;
+	}
+	SocketHandle host = connectTo(config.targetHost, config.targetPort);
+	if (host == INVALID_SOCKET_HANDLE) {
+		closeSocket(client);
+		return;
+	}
+	setNoDelay(client, true); //the emulated link decides the timing, not nagle
+
+	std::uint32_t id = nextOwner++;
+	StreamPair& pair = streams[id];
+	pair.client = client;
+	pair.host = host;
+	std::cout << "Stream " << id << " opened" << "\n";
+}
+
+/// <summary>
+/// one read, it will not block after a poll, the chunk goes on the link behind anything still in flight
+/// </summary>
+void Proxy::readStream(std::uint32_t _pair, Direction _direction)
+{
+	auto it = streams.find(_pair);
+	if (it == streams.end()) {
+		return;
+	}
+	StreamPair& pair = it->second;
+
+	char buffer[READ_CHUNK];
+	int received = receiveBytes(_direction == UP ? pair.client : pair.host, buffer, sizeof(buffer));
+	Clock::time_point now = Clock::now();
+	if (received <= 0) {
+		queue(std::max(now, pair.lastArrival[_direction]), DeliveryKind::StreamClose, _direction, _pair, nullptr, 0); //after the data already on its way
+		pair.finished[_direction] = true;
+		return;
+	}
+
+	Clock::time_point arrival;
+	LinkFate fate = links[_direction].scheduleStream(now, received, arrival);
+	arrival = std::max(arrival, pair.lastArrival[_direction]);
+	pair.lastArrival[_direction] = arrival;
+	record(_direction, true, received, fate, now, arrival);
+	queue(arrival, DeliveryKind::StreamData, _direction, _pair, buffer, received);
+}
+
+/// <summary>
+/// a new sender gets its own socket towards the host, so replies can be told apart and the host sees one address per client
+/// </summary>
+void Proxy::readClientDatagrams()
+{
+	char buffer[65536];
+	SocketAddress from;
+	int received;
+	while ((received = receiveDatagram(datagramSocket, buffer, sizeof(buffer), from)) > 0)
+	{
+		Clock::time_point now = Clock::now();
+		std::uint64_t key = addressKey(from);
+		auto found = sessionByAddress.find(key);
+		std::uint32_t id;
+		if (found == sessionByAddress.end()) {
+			SocketHandle upstream = openDatagramSocket(0);
+			if (upstream == INVALID_SOCKET_HANDLE) {
+				continue;
+			}
+			id = nextOwner++;
+			DatagramSession& session = sessions[id];
+			session.client = from;
+			session.upstream = upstream;
+			sessionByAddress[key] = id;
+		}
+		else {
+			id = found->second;
+		}
+		sessions[id].lastSeen = now;
+
+		Clock::time_point arrival;
+		LinkFate fate = links[UP].scheduleDatagram(now, received, arrival);
+		record(UP, false, received, fate, now, arrival);
+		if (fate != LinkFate::Lost && fate != LinkFate::Overflow) {
+			queue(arrival, DeliveryKind::Datagram, UP, id, buffer, received);
+		}
+	}
+}
+
+void Proxy::readHostDatagrams(std::uint32_t _session)
+{
+	auto it = sessions.find(_session);
+	if (it == sessions.end()) {
+		return;
+	}
+	char buffer[65536];
+	SocketAddress from;
+	int received;
+	while ((received = receiveDatagram(it->second.upstream, buffer, sizeof(buffer), from)) > 0)
+	{
+		Clock::time_point now = Clock::now();
+		Clock::time_point arrival;
+		LinkFate fate = links[DOWN].scheduleDatagram(now, received, arrival);
+		record(DOWN, false, received, fate, now, arrival);
+		if (fate != LinkFate::Lost && fate != LinkFate::Overflow) {
+			queue(arrival, DeliveryKind::Datagram, DOWN, _session, buffer, received);
+		}
+	}
+}
+
+void Proxy::deliverDue(Clock::time_point _now)
+{
+	while (!deliveries.empty() && deliveries.top().at <= _now) {
+		Delivery delivery = deliveries.top();
+		deliveries.pop();
+		deliver(delivery);
+	}
+}
+
+/// <summary>
+/// hands a packet to its far side, whatever it belonged to may have gone while it was in flight
+/// </summary>
+void Proxy::deliver(Delivery& _delivery)
+{
+	if (_delivery.kind == DeliveryKind::Datagram) {
+		auto it = sessions.find(_delivery.owner);
+		if (it == sessions.end()) {
+			return;
+		}
+		if (_delivery.direction == UP) {
+			sendDatagram(it->second.upstream, target, _delivery.data.data(), _delivery.data.size());
+		}
+		else {
+			sendDatagram(datagramSocket, it->second.client, _delivery.data.data(), _delivery.data.size());
+		}
+		return;
+	}
+
+	auto it = streams.find(_delivery.owner);
+	if (it == streams.end()) {
+		return;
+	}
+	if (_delivery.kind == DeliveryKind::StreamClose) {
+		closeStream(_delivery.owner);
+		return;
+	}
+
+	SocketHandle to = _delivery.direction == UP ? it->second.host : it->second.client;
+	std::size_t sent = 0;
+	while (sent < _delivery.data.size()) { //blocking, the game always reads so this is short
+		int result = sendBytes(to, _delivery.data.data() + sent, _delivery.data.size() - sent);
+		if (result <= 0) {
+			closeStream(_delivery.owner);
+			return;
+		}
+		sent += result;
+	}
+}
+
+void Proxy::closeStream(std::uint32_t _pair)
+{
+	auto it = streams.find(_pair);
+	if (it == streams.end()) {
+		return;
+	}
+	closeSocket(it->second.client);
+	closeSocket(it->second.host);
+	streams.erase(it);
+	std::cout << "Stream " << _pair << " closed" << "\n";
+}
+
+void Proxy::expireSessions(Clock::time_point _now)
+{
+	for (auto it = sessions.begin(); it != sessions.end();) {
+		if (_now - it->second.lastSeen > SESSION_TIMEOUT) {
+			sessionByAddress.erase(addressKey(it->second.client));
+			closeSocket(it->second.upstream);
+			it = sessions.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void Proxy::queue(Clock::time_point _at, DeliveryKind _kind, Direction _direction, std::uint32_t _owner, const char* _data, std::size_t _size)
+{
+	Delivery delivery{ _at, nextOrder++, _kind, _direction, _owner, {} };
+	if (_size > 0) {
+		delivery.data.assign(_data, _data + _size);
+	}
+	deliveries.push(std::move(delivery));
+}
+
+void Proxy::record(Direction _direction, bool _stream, std::size_t _size, LinkFate _fate, Clock::time_point _now, Clock::time_point _deliverAt)
+{
+	DirectionStats& totals = stats[_direction];
+	++totals.packets;
+	totals.bytes += _size;
+
+	bool arrives = _fate == LinkFate::Delivered || _fate == LinkFate::Reordered || _stream; //a lost stream segment still arrives, late
+	double delayMs = arrives ? std::chrono::duration<double, std::milli>(_deliverAt - _now).count() : 0.0;
+	if (arrives) {
+		totals.delaySumMs += delayMs;
+		totals.delayMaxMs = std::max(totals.delayMaxMs, delayMs);
+	}
+	if (_fate == LinkFate::Lost) {
+		++(_stream ? totals.retransmitted : totals.lost);
+	}
+	else if (_fate == LinkFate::Overflow) {
+		++totals.overflow;
+	}
+	else if (_fate == LinkFate::Reordered) {
+		++totals.reordered;
+	}
+
+	if (trace.is_open()) {
+		trace << std::chrono::duration<double, std::milli>(_now - started).count() << ","
+			<< DIRECTION_NAMES[_direction] << "," << (_stream ? "tcp" : "udp") << "," << _size << ","
+			<< delayMs << "," << (_stream && _fate == LinkFate::Lost ? "retransmitted" : fateName(_fate)) << "\n";
+	}
+}
+
+std::uint64_t Proxy::addressKey(const SocketAddress& _address)
+{
+	return (static_cast<std::uint64_t>(_address.sin_addr.s_addr) << 16) | _address.sin_port;
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "LinkModel.h"
+#include "Socket.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+struct ProxyConfig
+{
+	unsigned short listenPort = 53001; //clients connect here, tcp and udp
+	std::string targetHost = "127.0.0.1";
+	unsigned short targetPort = 53000; //the real host
+	LinkProfile up; //client to host
+	LinkProfile down; //host to client
+	std::uint32_t seed = 1;
+	std::string tracePath; //one csv row per packet, no trace when empty
+};
+
+/// <summary>
+/// sits between clients and the host and forwards both tcp and udp through an emulated link
+/// every client connection gets its own connection to the host, every udp sender its own udp socket,
+/// so the host sees each client at a distinct address exactly as it would without the proxy
+/// runs on one thread, packets wait in a queue ordered by when the link says they arrive
+/// </summary>
+class Proxy
+{
+public:
+	using Clock = LinkModel::Clock;
+
+	explicit Proxy(const ProxyConfig& _config);
+	~Proxy();
+
+	Proxy(const Proxy&) = delete;
+	Proxy& operator=(const Proxy&) = delete;
+
+	bool start(); //false if the port could not be bound or the target resolved
+	void poll(int _maxWaitMs); //one wait for traffic, then forwards whatever is due
+	void report(std::ostream& _out); //per direction totals since the last report
+
+private:
+	enum Direction
+	{
+		UP, //client to host
+		DOWN //host to client
+	};
+
+	enum class DeliveryKind
+	{
+		StreamData,
+		StreamClose, //the sender closed, queued behind its data
+		Datagram
+	};
+
+	/// a client connection and the connection opened to the host for it
+	struct StreamPair
+	{
+		SocketHandle client = INVALID_SOCKET_HANDLE;
+		SocketHandle host = INVALID_SOCKET_HANDLE;
+		Clock::time_point lastArrival[2]{}; //per direction, a stream never overtakes itself
+		bool finished[2]{}; //that side closed, its close is on the way and it is no longer read
+	};
+
+	/// a udp client and the socket that speaks to the host for it
+	struct DatagramSession
+	{
+		SocketAddress client{};
+		SocketHandle upstream = INVALID_SOCKET_HANDLE;
+		Clock::time_point lastSeen{};
+	};
+
+	struct Delivery
+	{
+		Clock::time_point at;
+		std::uint64_t order; //keeps deliveries due at the same moment in the order they were queued
+		DeliveryKind kind;
+		Direction direction;
+		std::uint32_t owner; //stream pair or datagram session id
+		std::vector<char> data;
+	};
+
+	struct LaterFirst
+	{
+		bool operator()(const Delivery& _first, const Delivery& _second) const
+		{
+			return _first.at != _second.at ? _first.at > _second.at : _first.order > _second.order;
+		}
+	};
+
+	struct DirectionStats
+	{
+		std::uint64_t packets = 0;
+		std::uint64_t bytes = 0;
+		std::uint64_t lost = 0;
+		std::uint64_t overflow = 0;
+		std::uint64_t reordered = 0;
+		std::uint64_t retransmitted = 0; //stream segments that were lost and sent again
+		double delaySumMs = 0.0;
+		double delayMaxMs = 0.0;
+	};
+
+	void acceptClients();
+	void readStream(std::uint32_t _pair, Direction _direction);
+	void readClientDatagrams();
+	void readHostDatagrams(std::uint32_t _session);
+	void deliverDue(Clock::time_point _now);
+	void deliver(Delivery& _delivery);
+	void closeStream(std::uint32_t _pair);
+	void expireSessions(Clock::time_point _now);
+
+	void queue(Clock::time_point _at, DeliveryKind _kind, Direction _direction, std::uint32_t _owner, const char* _data, std::size_t _size);
+	void record(Direction _direction, bool _stream, std::size_t _size, LinkFate _fate, Clock::time_point _now, Clock::time_point _deliverAt);
+
+	static std::uint64_t addressKey(const SocketAddress& _address);
+
+	ProxyConfig config;
+	SocketAddress target{};
+	LinkModel links[2];
+	DirectionStats stats[2];
+
+	SocketHandle listener = INVALID_SOCKET_HANDLE;
+	SocketHandle datagramSocket = INVALID_SOCKET_HANDLE;
+
+	std::unordered_map<std::uint32_t, StreamPair> streams;
+	std::unordered_map<std::uint32_t, DatagramSession> sessions;
+	std::unordered_map<std::uint64_t, std::uint32_t> sessionByAddress;
+	std::uint32_t nextOwner = 1;
+
+	std::priority_queue<Delivery, std::vector<Delivery>, LaterFirst> deliveries;
+	std::uint64_t nextOrder = 0;
+
+	/// what an entry in the poll set after the two listening sockets belongs to
+	struct PollEntry
+	{
+		std::uint32_t owner;
+		Direction direction; //the direction data read from it travels
+		bool session;
+	};
+	std::vector<pollfd> pollSet; //rebuilt each poll
+	std::vector<PollEntry> pollEntries;
+
+	Clock::time_point started;
+	Clock::time_point nextExpiry;
+	std::ofstream trace;
+};
@@ -0,0 +1,157 @@
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "Proxy.h"
+
+namespace
+{
+	volatile std::sig_atomic_t stopRequested = 0;
+
+	void onSignal(int)
+	{
+		stopRequested = 1;
+	}
+
+	/// <summary>
+	/// named starting points, any of the link options after --profile adjust it
+	/// </summary>
+	bool applyProfile(const std::string& _name, LinkProfile& _link)
+	{
+		if (_name == "lan") {
+			_link = LinkProfile{ 1.0, 0.5, 0.0, 0.0, 0.0 };
+		}
+		else if (_name == "broadband") {
+			_link = LinkProfile{ 20.0, 5.0, 0.5, 0.0, 0.0 };
+		}
+		else if (_name == "wifi") {
+			_link = LinkProfile{ 15.0, 15.0, 1.0, 1.0, 0.0 };
+		}
+		else if (_name == "mobile") {
+			_link = LinkProfile{ 60.0, 30.0, 2.0, 2.0, 2000.0 };
+		}
+		else if (_name == "bad") {
+			_link = LinkProfile{ 120.0, 50.0, 5.0, 5.0, 500.0 };
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// reads --listen, --target-host, --target-port, --profile, --latency, --jitter, --loss, --reorder,
+	/// --bandwidth, --seed, --trace and --report, the link options apply to both directions
+	/// </summary>
+	bool parseArguments(int argc, char* argv[], ProxyConfig& _config, int& _reportSeconds)
+	{
+		LinkProfile link;
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string argument = argv[i];
+			if (argument == "--listen" && i + 1 < argc) {
+				_config.listenPort = static_cast<unsigned short>(std::atoi(argv[++i]));
+			}
+			else if (argument == "--target-host" && i + 1 < argc) {
+				_config.targetHost = argv[++i];
+			}
+			else if (argument == "--target-port" && i + 1 < argc) {
+				_config.targetPort = static_cast<unsigned short>(std::atoi(argv[++i]));
+			}
+			else if (argument == "--profile" && i + 1 < argc) {
+				if (!applyProfile(argv[++i], link)) {
+					std::cerr << "profile is lan, broadband, wifi, mobile or bad" << "\n";
+					return false;
+				}
+			}
+			else if (argument == "--latency" && i + 1 < argc) {
+				link.latencyMs = std::atof(argv[++i]);
+			}
+			else if (argument == "--jitter" && i + 1 < argc) {
+				link.jitterMs = std::atof(argv[++i]);
+			}
+			else if (argument == "--loss" && i + 1 < argc) {
+				link.lossPercent = std::atof(argv[++i]);
+			}
+			else if (argument == "--reorder" && i + 1 < argc) {
+				link.reorderPercent = std::atof(argv[++i]);
+			}
+			else if (argument == "--bandwidth" && i + 1 < argc) {
+				link.bandwidthKbps = std::atof(argv[++i]);
+			}
+			else if (argument == "--seed" && i + 1 < argc) {
+				_config.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (argument == "--trace" && i + 1 < argc) {
+				_config.tracePath = argv[++i];
+			}
+			else if (argument == "--report" && i + 1 < argc) {
+				_reportSeconds = std::atoi(argv[++i]);
+			}
+			else {
+				std::cerr << "usage: " << argv[0] << " [--listen 53001] [--target-host 127.0.0.1] [--target-port 53000]"
+					<< " [--profile lan|broadband|wifi|mobile|bad] [--latency ms] [--jitter ms] [--loss %] [--reorder %]"
+					<< " [--bandwidth kbit/s] [--seed 1] [--trace file.csv] [--report 5]" << "\n";
+				return false;
+			}
+		}
+		if (link.latencyMs < 0.0 || link.jitterMs < 0.0 || link.lossPercent < 0.0 || link.lossPercent > 100.0 ||
+			link.reorderPercent < 0.0 || link.reorderPercent > 100.0 || link.bandwidthKbps < 0.0 || _reportSeconds <= 0) {
+			std::cerr << "delays and bandwidth cannot be negative, percentages are 0 to 100, report must be positive" << "\n";
+			return false;
+		}
+		_config.up = link;
+		_config.down = link;
+		return true;
+	}
+}
+
+/// <summary>
+/// network condition emulator, point the client at the listen port and the proxy at the host
+/// </summary>
+/// <returns>success or failure</returns>
+int main(int argc, char* argv[])
+{
+	ProxyConfig config;
+	int reportSeconds = 5;
+	if (!parseArguments(argc, argv, config, reportSeconds)) {
+		return 1;
+	}
+
+	std::signal(SIGINT, onSignal);
+	std::signal(SIGTERM, onSignal);
+
+	if (!initSockets()) {
+		return 1;
+	}
+
+	{
+		Proxy proxy(config);
+		if (!proxy.start()) {
+			shutdownSockets();
+			return 1;
+		}
+		std::cout << "Forwarding " << config.listenPort << " to " << config.targetHost << ":" << config.targetPort
+			<< " with " << config.up.latencyMs << " ms latency, " << config.up.jitterMs << " ms jitter, "
+			<< config.up.lossPercent << "% loss, " << config.up.reorderPercent << "% reorder, "
+			<< (config.up.bandwidthKbps > 0.0 ? std::to_string(static_cast<int>(config.up.bandwidthKbps)) + " kbit/s" : std::string("no bandwidth cap"))
+			<< ", seed " << config.seed << "\n";
+
+		using Clock = Proxy::Clock;
+		Clock::time_point nextReport = Clock::now() + std::chrono::seconds(reportSeconds);
+		while (!stopRequested)
+		{
+			proxy.poll(10);
+			if (Clock::now() >= nextReport) {
+				proxy.report(std::cout);
+				nextReport += std::chrono::seconds(reportSeconds);
+			}
+		}
+		std::cout << "Shutting down." << "\n";
+		proxy.report(std::cout);
+	}
+
+	shutdownSockets();
+	return 0;
+}
@@ -0,0 +1,116 @@
+#include "MappedFile.h"
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& _path)
+{
+	close();
+	HANDLE file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		std::cerr << "Could not open " << _path << ": " << GetLastError() << "\n";
+		return false;
+	}
+	fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		std::cerr << _path << " is empty" << "\n";
+		close();
+		return false;
+	}
+
+	mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr) {
+		std::cerr << "Could not map " << _path << ": " << GetLastError() << "\n";
+		close();
+		return false;
+	}
+	view = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (view == nullptr) {
+		std::cerr << "Could not map " << _path << ": " << GetLastError() << "\n";
+		close();
+		return false;
+	}
+	length = static_cast<std::size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (view != nullptr) {
+		UnmapViewOfFile(view);
+		view = nullptr;
+	}
+	if (mappingHandle != nullptr) {
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+	}
+	if (fileHandle != nullptr) {
+		CloseHandle(fileHandle);
+		fileHandle = nullptr;
+	}
+	length = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& _path)
+{
+	close();
+	descriptor = ::open(_path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		std::cerr << "Could not open " << _path << "\n";
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+		std::cerr << _path << " is empty" << "\n";
+		close();
+		return false;
+	}
+
+	void* mapped = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (mapped == MAP_FAILED) {
+		std::cerr << "Could not map " << _path << "\n";
+		close();
+		return false;
+	}
+	madvise(mapped, static_cast<std::size_t>(status.st_size), MADV_SEQUENTIAL); //replays read front to back
+	view = static_cast<const char*>(mapped);
+	length = static_cast<std::size_t>(status.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (view != nullptr) {
+		munmap(const_cast<char*>(view), length);
+		view = nullptr;
+	}
+	if (descriptor >= 0) {
+		::close(descriptor);
+		descriptor = -1;
+	}
+	length = 0;
+}
+
+#endif
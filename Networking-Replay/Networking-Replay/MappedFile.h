@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/// <summary>
+/// a whole file mapped read only into memory, pages are read in as they are touched
+/// so a long recording costs nothing until it is walked and nothing is copied when it is
+/// </summary>
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& _path); //false if missing, empty or unmappable, reason already logged
+	void close();
+
+	const char* data() const { return view; }
+	std::size_t size() const { return length; }
+
+private:
+	const char* view = nullptr;
+	std::size_t length = 0;
+
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int descriptor = -1;
+#endif
+};
@@ -0,0 +1,138 @@
+#include "MatchReplay.h"
+#include <algorithm>
+#include <cstring>
+
+/// <summary>
+/// one pass over the records finds every keyframe and how many steps there are, the payloads are not touched
+/// </summary>
+bool MatchReplay::open(const char* _data, std::size_t _size)
+{
+	ByteReader header(_data, _size);
+	if (!readRecordingHeader(header, config)) {
+		return false;
+	}
+	data = _data;
+	size = _size;
+	firstRecord = header.getPosition();
+
+	keyframes.clear();
+	recordedTicks = 0;
+	RecordCursor cursor(data, size, firstRecord);
+	Record record;
+	while (cursor.next(record)) {
+		if (record.type == RecordType::Step) {
+			++recordedTicks;
+		}
+		else if (record.type == RecordType::Keyframe) {
+			ByteReader reader(record.payload, record.size);
+			std::uint64_t tick = reader.read<std::uint64_t>();
+			if (!reader.failed()) {
+				keyframes.push_back({ tick, record.offset });
+			}
+		}
+	}
+	truncated = cursor.getPosition() < size;
+	return true;
+}
+
+void MatchReplay::run(Simulation& _simulation, bool _verify, ReplayStats& _stats, std::uint64_t _untilTick)
+{
+	RecordCursor cursor(data, size, firstRecord);
+	play(_simulation, cursor, _untilTick, _verify, _stats);
+}
+
+bool MatchReplay::seek(Simulation& _simulation, std::uint64_t _tick, ReplayStats& _stats)
+{
+	auto after = std::upper_bound(keyframes.begin(), keyframes.end(), _tick,
+		[](std::uint64_t _target, const KeyframeEntry& _entry) { return _target < _entry.tick; });
+	if (after == keyframes.begin()) {
+		run(_simulation, false, _stats, _tick); //before the first keyframe, step from the start
+		return _simulation.getTick() == _tick;
+	}
+
+	const KeyframeEntry& keyframe = *(after - 1);
+	RecordCursor cursor(data, size, keyframe.offset);
+	Record record;
+	cursor.next(record);
+	ByteReader reader(record.payload, record.size);
+	reader.read<std::uint64_t>();
+	if (!_simulation.loadState(reader)) {
+		return false;
+	}
+	play(_simulation, cursor, _tick, false, _stats);
+	return _simulation.getTick() == _tick;
+}
+
+void MatchReplay::play(Simulation& _simulation, RecordCursor& _cursor, std::uint64_t _untilTick, bool _verify, ReplayStats& _stats)
+{
+	if (_simulation.getTick() >= _untilTick) {
+		return; //a seek that landed on its keyframe, the inputs after it belong to the next step
+	}
+	Record record;
+	while (_cursor.next(record)) {
+		ByteReader reader(record.payload, record.size);
+		switch (record.type)
+		{
+		case RecordType::Join: {
+			int recorded = reader.read<std::int32_t>();
+			++_stats.joins;
+			if (_simulation.addPlayer() != recorded) {
+				mismatch(_simulation, _stats);
+			}
+			break;
+		}
+		case RecordType::Leave:
+			++_stats.leaves;
+			_simulation.removePlayer(reader.read<std::int32_t>());
+			break;
+		case RecordType::Input: {
+			RecordedInput input;
+			input.playerID = reader.read<std::int32_t>();
+			input.xDir = reader.read<std::int8_t>();
+			input.yDir = reader.read<std::int8_t>();
+			input.viewTick = reader.read<std::uint32_t>();
+			++_stats.inputs;
+			_simulation.queueInput(input.playerID, input.xDir, input.yDir, input.viewTick);
+			break;
+		}
+		case RecordType::Step: {
+			if (_simulation.getTick() >= _untilTick) {
+				return;
+			}
+			_simulation.step();
+			++_stats.steps;
+			if (_simulation.getTick() >= _untilTick) {
+				return; //joins after this belong to the next step
+			}
+			break;
+		}
+		case RecordType::Transition:
+			if (_verify) {
+				MatchState recorded = reader.read<std::uint8_t>() != 0 ? MatchState::GameOver : MatchState::Playing;
+				if (_simulation.getState() != recorded) {
+					mismatch(_simulation, _stats);
+				}
+			}
+			break;
+		case RecordType::Keyframe:
+			if (_verify) {
+				reader.read<std::uint64_t>();
+				savedState.clear();
+				ByteWriter writer(savedState);
+				_simulation.saveState(writer);
+				++_stats.keyframesChecked;
+				if (savedState.size() != reader.remaining() || std::memcmp(savedState.data(), record.payload + reader.getPosition(), savedState.size()) != 0) {
+					mismatch(_simulation, _stats);
+				}
+			}
+			break;
+		}
+	}
+}
+
+void MatchReplay::mismatch(const Simulation& _simulation, ReplayStats& _stats)
+{
+	if (_stats.mismatches++ == 0) {
+		_stats.firstMismatchTick = _simulation.getTick();
+	}
+}
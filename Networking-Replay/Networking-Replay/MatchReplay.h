@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "MatchRecording.h"
+#include "Simulation.h"
+
+/// what a replay did and whether it matched the recording
+struct ReplayStats
+{
+	std::uint64_t steps = 0;
+	std::uint64_t inputs = 0;
+	std::uint64_t joins = 0;
+	std::uint64_t leaves = 0;
+	std::uint64_t keyframesChecked = 0;
+	std::uint64_t mismatches = 0; //joins given another id, transitions or keyframes that differ
+	std::uint64_t firstMismatchTick = 0; //0 if none
+};
+
+/// <summary>
+/// steps a fresh simulation through a recording held in memory, checking every transition and keyframe
+/// against what the host saw, or jumps to any tick by restoring the keyframe before it and stepping on
+/// </summary>
+class MatchReplay
+{
+public:
+	static const std::uint64_t END = std::numeric_limits<std::uint64_t>::max();
+
+	bool open(const char* _data, std::size_t _size); //reads the header and indexes the keyframes
+
+	const SimulationConfig& getConfig() const { return config; }
+	std::uint64_t getRecordedTicks() const { return recordedTicks; }
+	std::size_t getKeyframeCount() const { return keyframes.size(); }
+	bool isTruncated() const { return truncated; } //stopped at a damaged record, what came before still replays
+
+	/// <summary>
+	/// replays from the start, _simulation must be new and built with getConfig
+	/// </summary>
+	void run(Simulation& _simulation, bool _verify, ReplayStats& _stats, std::uint64_t _untilTick = END);
+
+	/// <summary>
+	/// leaves _simulation as it was after step _tick, from the nearest keyframe at or before it
+	/// </summary>
+	/// <returns>false if the recording ends first or its keyframe would not load</returns>
+	bool seek(Simulation& _simulation, std::uint64_t _tick, ReplayStats& _stats);
+
+private:
+	struct KeyframeEntry
+	{
+		std::uint64_t tick;
+		std::size_t offset; //of the record
+	};
+
+	void play(Simulation& _simulation, RecordCursor& _cursor, std::uint64_t _untilTick, bool _verify, ReplayStats& _stats);
+	void mismatch(const Simulation& _simulation, ReplayStats& _stats);
+
+	const char* data = nullptr;
+	std::size_t size = 0;
+	std::size_t firstRecord = 0;
+	SimulationConfig config;
+
+	std::vector<KeyframeEntry> keyframes; //in tick order
+	std::uint64_t recordedTicks = 0;
+	bool truncated = false;
+
+	std::vector<char> savedState; //scratch for comparing against keyframes
+};
@@ -0,0 +1,138 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "MappedFile.h"
+#include "MatchReplay.h"
+
+namespace
+{
+	struct ReplayConfig
+	{
+		std::string path;
+		bool seeking = false;
+		std::uint64_t seekTick = 0;
+		int repeat = 1; //whole replays back to back, for timing
+		bool verify = true;
+	};
+
+	/// <summary>
+	/// reads the recording path, --seek, --repeat and --no-verify
+	/// </summary>
+	bool parseArguments(int argc, char* argv[], ReplayConfig& _config)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string argument = argv[i];
+			if (argument == "--seek" && i + 1 < argc) {
+				_config.seeking = true;
+				_config.seekTick = std::strtoull(argv[++i], nullptr, 10);
+			}
+			else if (argument == "--repeat" && i + 1 < argc) {
+				_config.repeat = std::atoi(argv[++i]);
+			}
+			else if (argument == "--no-verify") {
+				_config.verify = false;
+			}
+			else if (_config.path.empty() && argument.compare(0, 2, "--") != 0) {
+				_config.path = argument;
+			}
+			else {
+				_config.path.clear();
+				break;
+			}
+		}
+		if (_config.path.empty()) {
+			std::cerr << "usage: " << argv[0] << " recording.tagrec [--seek tick] [--repeat 1] [--no-verify]" << "\n";
+			return false;
+		}
+		if (_config.repeat <= 0) {
+			std::cerr << "repeat must be positive" << "\n";
+			return false;
+		}
+		return true;
+	}
+
+	void printState(const Simulation& _simulation)
+	{
+		std::cout << "tick " << _simulation.getTick()
+			<< (_simulation.getState() == MatchState::GameOver ? " game over" : " playing")
+			<< " survival " << _simulation.getSurvivalTime() << " s" << "\n";
+		const PickUpState& pickUp = _simulation.getPickUp();
+		if (pickUp.active) {
+			std::cout << "pickup at " << pickUp.x.toFloat() << ", " << pickUp.y.toFloat() << "\n";
+		}
+		for (const PlayerState& player : _simulation.getPlayers()) {
+			std::cout << "player " << player.id << " at " << player.x.toFloat() << ", " << player.y.toFloat()
+				<< (player.isIt ? " it" : "") << (player.invisible ? " invisible" : "") << "\n";
+		}
+	}
+}
+
+/// <summary>
+/// replays a recorded match headless as fast as it will go, checking it steps exactly as the host did,
+/// or shows the match at one tick
+/// </summary>
+/// <returns>0 if the replay matched the recording</returns>
+int main(int argc, char* argv[])
+{
+	ReplayConfig config;
+	if (!parseArguments(argc, argv, config)) {
+		return 1;
+	}
+
+	MappedFile file;
+	if (!file.open(config.path)) {
+		return 1;
+	}
+	MatchReplay replay;
+	if (!replay.open(file.data(), file.size())) {
+		std::cerr << config.path << " is not a match recording this build can read" << "\n";
+		return 1;
+	}
+	const SimulationConfig& simulationConfig = replay.getConfig();
+	std::cout << config.path << ": " << replay.getRecordedTicks() << " ticks at " << simulationConfig.tickRate << " Hz ("
+		<< replay.getRecordedTicks() / simulationConfig.tickRate << " s), " << replay.getKeyframeCount() << " keyframes, room of "
+		<< simulationConfig.maxPlayers << ", seed " << simulationConfig.seed << (replay.isTruncated() ? ", cut short" : "") << "\n";
+
+	std::streambuf* console = std::cout.rdbuf(nullptr); //the simulation logs joins and tags
+	if (config.seeking) {
+		Simulation simulation(simulationConfig);
+		ReplayStats stats;
+		bool found = replay.seek(simulation, config.seekTick, stats);
+		std::cout.rdbuf(console);
+		if (!found) {
+			std::cerr << "Could not reach tick " << config.seekTick << ", the recording ends at " << simulation.getTick() << "\n";
+			return 1;
+		}
+		std::cout << "stepped " << stats.steps << " ticks to get there" << "\n";
+		printState(simulation);
+		return 0;
+	}
+
+	using Clock = std::chrono::steady_clock;
+	ReplayStats stats;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < config.repeat; ++i) {
+		Simulation simulation(simulationConfig);
+		replay.run(simulation, config.verify, stats);
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::cout.rdbuf(console);
+
+	double matchSeconds = static_cast<double>(stats.steps) / simulationConfig.tickRate;
+	std::cout << "replayed " << stats.steps << " ticks, " << stats.inputs << " inputs, " << stats.joins << " joins, "
+		<< stats.leaves << " leaves in " << seconds * 1000.0 << " ms" << "\n";
+	if (seconds > 0.0) {
+		std::cout << stats.steps / seconds << " ticks/s, " << matchSeconds / seconds << "x real time" << "\n";
+	}
+	if (!config.verify) {
+		return 0;
+	}
+	if (stats.mismatches != 0) {
+		std::cout << stats.mismatches << " mismatches, the first at tick " << stats.firstMismatchTick << "\n";
+		return 1;
+	}
+	std::cout << "matched the recording, " << stats.keyframesChecked << " keyframes checked" << "\n";
+	return 0;
+}
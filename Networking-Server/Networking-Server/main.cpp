@@ -0,0 +1,138 @@
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "Server.h"
+
+namespace
+{
+	volatile std::sig_atomic_t stopRequested = 0;
+
+	void onSignal(int)
+	{
+		stopRequested = 1;
+	}
+
+	/// <summary>
+	/// reads --port, --tick-rate, --snapshot-interval, --max-players, --max-rooms, --threads, --metrics-port, --record and --seed, anything missing keeps its default
+	/// </summary>
+	bool parseArguments(int argc, char* argv[], ServerConfig& _config)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string argument = argv[i];
+			if (argument == "--port" && i + 1 < argc) {
+				_config.port = static_cast<unsigned short>(std::atoi(argv[++i]));
+			}
+			else if (argument == "--tick-rate" && i + 1 < argc) {
+				_config.simulation.tickRate = std::atoi(argv[++i]);
+			}
+			else if (argument == "--snapshot-interval" && i + 1 < argc) {
+				_config.snapshotInterval = std::atoi(argv[++i]);
+			}
+			else if (argument == "--max-players" && i + 1 < argc) {
+				_config.simulation.maxPlayers = std::atoi(argv[++i]);
+			}
+			else if (argument == "--max-rooms" && i + 1 < argc) {
+				_config.maxRooms = std::atoi(argv[++i]);
+			}
+			else if (argument == "--threads" && i + 1 < argc) {
+				_config.workerThreads = std::atoi(argv[++i]);
+			}
+			else if (argument == "--metrics-port" && i + 1 < argc) {
+				_config.metricsPort = static_cast<unsigned short>(std::atoi(argv[++i]));
+			}
+			else if (argument == "--record" && i + 1 < argc) {
+				_config.recordDirectory = argv[++i];
+			}
+			else if (argument == "--seed" && i + 1 < argc) {
+				_config.simulation.seed = std::strtoull(argv[++i], nullptr, 10);
+			}
+			else {
+				std::cerr << "usage: " << argv[0] << " [--port 53000] [--tick-rate 60] [--snapshot-interval 1] [--max-players 32] [--max-rooms 256] [--threads 0] [--metrics-port 0] [--record directory] [--seed 0]" << "\n";
+				return false;
+			}
+		}
+		if (_config.simulation.tickRate <= 0 || _config.snapshotInterval <= 0 || _config.simulation.maxPlayers <= 0 ||
+			_config.maxRooms <= 0 || _config.workerThreads < 0) {
+			std::cerr << "tick rate, snapshot interval, max players and max rooms must be positive" << "\n";
+			return false;
+		}
+		return true;
+	}
+}
+
+/// <summary>
+/// headless dedicated server entry point, no window, every player is a client
+/// </summary>
+/// <returns>success or failure</returns>
+int main(int argc, char* argv[])
+{
+	ServerConfig config;
+	config.maxRooms = 256; //nothing is drawn here so every room is as good as the first
+	if (!parseArguments(argc, argv, config)) {
+		return 1;
+	}
+
+	std::signal(SIGINT, onSignal);
+	std::signal(SIGTERM, onSignal);
+
+	if (!initSockets()) {
+		return 1;
+	}
+
+	Server server(config);
+	if (!server.start()) {
+		shutdownSockets();
+		return 1;
+	}
+	std::cout << "Ticking at " << config.simulation.tickRate << " Hz for up to " << server.getSimulation().getMaxPlayers() << " players" << "\n";
+
+	using Clock = std::chrono::steady_clock;
+	const Clock::duration tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / config.simulation.tickRate));
+
+	Clock::time_point nextTick = Clock::now();
+	Clock::time_point nextReport = nextTick + std::chrono::seconds(5);
+	Clock::duration busyTime{};
+	Clock::duration worstTick{};
+	int ticks = 0;
+
+	while (!stopRequested)
+	{
+		Clock::time_point tickStart = Clock::now();
+		server.tick();
+		Clock::duration cost = Clock::now() - tickStart;
+
+		busyTime += cost;
+		worstTick = std::max(worstTick, cost);
+		++ticks;
+
+		if (tickStart >= nextReport) { //tick cost without any rendering in the way
+			using Millis = std::chrono::duration<double, std::milli>;
+			std::cout << "ticks " << ticks
+				<< " clients " << server.getClientCount()
+				<< " rooms " << server.getRoomCount()
+				<< " dropped " << server.getDroppedEvents()
+				<< " evicted " << server.getEvictedClients()
+				<< " avg " << Millis(busyTime).count() / ticks << " ms"
+				<< " max " << Millis(worstTick).count() << " ms" << "\n";
+			busyTime = worstTick = Clock::duration::zero();
+			ticks = 0;
+			nextReport = tickStart + std::chrono::seconds(5);
+		}
+
+		nextTick += tickDuration;
+		if (Clock::now() - nextTick > std::chrono::seconds(1)) {
+			nextTick = Clock::now(); //fell far behind, dont try to catch up in a burst
+		}
+		std::this_thread::sleep_until(nextTick);
+	}
+
+	std::cout << "Shutting down." << "\n";
+	server.stop();
+	shutdownSockets();
+	return 0;
+}
@@ -1,11 +1,9 @@
 #pragma once
 #include<SFML/Graphics.hpp>
+#include"WorldConstants.h"
 
 const char* const APPLE_SPRITE = "ASSETS\\IMAGES\\Apple.png";
 
 const char* const FONT = "ASSETS\\FONTS\\edge.ttf";
 
-const sf::Color GRAY = sf::Color(21, 21, 21);
-
-const int SCREEN_WIDTH = 1200;
-const int SCREEN_HEIGHT = 700;
\ No newline at end of file
+const sf::Color GRAY = sf::Color(21, 21, 21);
\ No newline at end of file
@@ -1,15 +1,13 @@
 #include "InvisibilityPickUp.h"
 
-void InvisibilityPickUp::render(sf::RenderWindow& _window)
+InvisibilityPickUp::~InvisibilityPickUp()
 {
-	_window.draw(shape);
+	shapes.remove(shape);
 }
 
 void InvisibilityPickUp::initShape()
 {
-	shape.setRadius(5);
-	shape.setOrigin(5, 5);
-	shape.setFillColor(sf::Color::Yellow);
+	shape = shapes.add(sf::Vector2f(5, 5), sf::Vector2f(), sf::Color::Yellow); //radius 5 around the position
 
-	shape.setPosition(position);
+	shapes.setPosition(shape, position);
 }
@@ -1,17 +1,19 @@
 #pragma once
 #include<SFML/Graphics.hpp>
+#include"ShapeBatch.h"
 
 class InvisibilityPickUp
 {
 public:
-	InvisibilityPickUp(sf::Vector2f _pos) : position(_pos) { initShape(); }
+	InvisibilityPickUp(sf::Vector2f _pos, ShapeBatch& _shapes) : position(_pos), shapes(_shapes) { initShape(); }
+	~InvisibilityPickUp();
 
-	void render(sf::RenderWindow& _window);
-
-	sf::CircleShape shape;
+	InvisibilityPickUp(const InvisibilityPickUp&) = delete;
+	InvisibilityPickUp& operator=(const InvisibilityPickUp&) = delete;
 
 	sf::Vector2f position;
 private:
+	ShapeBatch& shapes; //drawn with the players
+	int shape = ShapeBatch::NONE;
 	void initShape();
 };
-
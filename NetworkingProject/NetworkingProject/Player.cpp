@@ -1,21 +1,26 @@
 #include "Player.h"
 
-void Player::move(sf::Vector2f _vel)
+Player::~Player()
 {
-	sf::Vector2f newPos = playerShape.getPosition() + _vel * 3.f;
-	playerShape.setPosition(newPos);
-
-	indicator.setPosition(sf::Vector2f(playerShape.getPosition().x, playerShape.getPosition().y - 40));
+	bodies.remove(body);
+	if (indicator != ShapeBatch::NONE) {
+		indicators.remove(indicator);
+	}
 }
 
-void Player::render(sf::RenderWindow& _window)
+void Player::move(sf::Vector2f _vel)
 {
-	_window.draw(playerShape);
+	updatePlayerPosition(position + _vel * 3.f);
 }
 
 void Player::updatePlayerPosition(sf::Vector2f _playerPos)
 {
-	playerShape.setPosition(_playerPos);
+	position = _playerPos;
+	bodies.setPosition(body, _playerPos);
+
+	if (indicator != ShapeBatch::NONE) {
+		indicators.setPosition(indicator, sf::Vector2f(_playerPos.x, _playerPos.y - 40)); //indicator follows synced positions too
+	}
 }
 
 void Player::invisiblePowerUp(bool _currentPlayer)
@@ -24,14 +29,14 @@ void Player::invisiblePowerUp(bool _currentPlayer)
 	{
 		if(currentColor == sf::Color::Green)
 		{
-			playerShape.setFillColor(sf::Color(0, 255, 0, 100)); //alpha lower to indicate invis
+			bodies.setColor(body, sf::Color(0, 255, 0, 100)); //alpha lower to indicate invis
 		} else
 		{
-			playerShape.setFillColor(sf::Color(155, 0, 0, 100)); //alpha lower to indicate invis
+			bodies.setColor(body, sf::Color(155, 0, 0, 100)); //alpha lower to indicate invis
 		}
 	}else
 	{
-		playerShape.setFillColor(sf::Color::Transparent); //if not current player make invisible
+		bodies.setColor(body, sf::Color::Transparent); //if not current player make invisible
 	}
 }
 
@@ -44,17 +49,23 @@ void Player::setColor()
 	{
 		currentColor = sf::Color::Red;
 	}
-	playerShape.setFillColor(currentColor);
-	indicator.setFillColor(currentColor);
+	bodies.setColor(body, currentColor);
+	if (indicator != ShapeBatch::NONE) {
+		indicators.setColor(indicator, currentColor);
+	}
 }
 
-void Player::initShape()
+void Player::showIndicator()
 {
-	playerShape.setRadius(15);
-	playerShape.setOrigin(15, 15);
+	if (indicator == ShapeBatch::NONE) {
+		indicator = indicators.add(sf::Vector2f(5, 20), sf::Vector2f(2, 10), currentColor);
+		indicators.setPosition(indicator, sf::Vector2f(position.x, position.y - 40));
+	}
+}
 
-	indicator.setSize(sf::Vector2f(5, 20));
-	indicator.setOrigin(2, 10);
+void Player::initShape()
+{
+	body = bodies.add(sf::Vector2f(15, 15), sf::Vector2f(), sf::Color::Green); //radius 15 around the position
 
 	setColor();
 }
@@ -0,0 +1,93 @@
+#include "ShapeBatch.h"
+#include <cmath>
+
+/// <summary>
+/// a fan of triangles from the centre, the same points an sf::CircleShape would use
+/// </summary>
+ShapeBatch ShapeBatch::circles(std::size_t _points)
+{
+	const float PI = 3.14159265f;
+	std::vector<sf::Vector2f> outline;
+	outline.reserve(_points * 3);
+	for (std::size_t i = 0; i < _points; ++i) {
+		float from = 2.f * PI * i / _points;
+		float to = 2.f * PI * (i + 1) / _points;
+		outline.push_back(sf::Vector2f(0.f, 0.f));
+		outline.push_back(sf::Vector2f(std::cos(from), std::sin(from)));
+		outline.push_back(sf::Vector2f(std::cos(to), std::sin(to)));
+	}
+	return ShapeBatch(std::move(outline));
+}
+
+ShapeBatch ShapeBatch::rectangles()
+{
+	return ShapeBatch({
+		sf::Vector2f(0.f, 0.f), sf::Vector2f(1.f, 0.f), sf::Vector2f(1.f, 1.f),
+		sf::Vector2f(0.f, 0.f), sf::Vector2f(1.f, 1.f), sf::Vector2f(0.f, 1.f) });
+}
+
+int ShapeBatch::add(sf::Vector2f _size, sf::Vector2f _origin, sf::Color _color)
+{
+	int shape;
+	if (!freeShapes.empty()) {
+		shape = freeShapes.back(); //reuse a run before growing the array
+		freeShapes.pop_back();
+	}
+	else {
+		shape = static_cast<int>(shapes.size());
+		shapes.emplace_back();
+		vertices.resize(shapes.size() * outline.size());
+	}
+	shapes[shape] = Shape{ sf::Vector2f(), _size, _origin, sf::Color::Transparent };
+	setColor(shape, _color);
+	place(shape);
+	return shape;
+}
+
+/// <summary>
+/// no vertices move down, the run is folded to a point with no area so nothing is filled for it
+/// </summary>
+void ShapeBatch::remove(int _shape)
+{
+	shapes[_shape].size = sf::Vector2f();
+	place(_shape);
+	freeShapes.push_back(_shape);
+}
+
+void ShapeBatch::setPosition(int _shape, sf::Vector2f _position)
+{
+	if (shapes[_shape].position == _position) {
+		return; //still players cost nothing
+	}
+	shapes[_shape].position = _position;
+	place(_shape);
+}
+
+void ShapeBatch::setColor(int _shape, sf::Color _color)
+{
+	if (shapes[_shape].color == _color) {
+		return;
+	}
+	shapes[_shape].color = _color;
+	std::size_t first = static_cast<std::size_t>(_shape) * outline.size();
+	for (std::size_t i = 0; i < outline.size(); ++i) {
+		vertices[first + i].color = _color;
+	}
+}
+
+void ShapeBatch::draw(sf::RenderTarget& _target, sf::RenderStates _states) const
+{
+	if (getCount() != 0) {
+		_target.draw(vertices, _states);
+	}
+}
+
+void ShapeBatch::place(int _shape)
+{
+	const Shape& shape = shapes[_shape];
+	sf::Vector2f corner = shape.position - shape.origin;
+	std::size_t first = static_cast<std::size_t>(_shape) * outline.size();
+	for (std::size_t i = 0; i < outline.size(); ++i) {
+		vertices[first + i].position = sf::Vector2f(corner.x + outline[i].x * shape.size.x, corner.y + outline[i].y * shape.size.y);
+	}
+}
@@ -0,0 +1,111 @@
+#include "BitStream.h"
+#include <cmath>
+
+std::uint32_t Quantization::quantize(float _value) const
+{
+	if (_value <= min) {
+		return 0;
+	}
+	if (_value >= max) {
+		return maxValue();
+	}
+	return static_cast<std::uint32_t>(std::lround((_value - min) / (max - min) * static_cast<float>(maxValue())));
+}
+
+float Quantization::dequantize(std::uint32_t _value) const
+{
+	return min + static_cast<float>(_value) * step();
+}
+
+BitWriter::BitWriter(char* _data, std::size_t _capacity) :
+	data(_data),
+	capacity(_capacity)
+{
+}
+
+void BitWriter::write(std::uint32_t _value, int _bits)
+{
+	std::uint64_t mask = (std::uint64_t{ 1 } << _bits) - 1;
+	scratch |= (static_cast<std::uint64_t>(_value) & mask) << scratchBits;
+	scratchBits += _bits;
+
+	while (scratchBits >= 8) { //scratch never holds more than 39 bits
+		if (bytes == capacity) {
+			overflow = true;
+		}
+		else {
+			data[bytes++] = static_cast<char>(scratch & 0xFF);
+		}
+		scratch >>= 8;
+		scratchBits -= 8;
+	}
+}
+
+void BitWriter::writeVarUint(std::uint32_t _value)
+{
+	do {
+		std::uint32_t chunk = _value & 0xF;
+		_value >>= 4;
+		write(chunk | (_value != 0 ? 0x10u : 0u), 5);
+	} while (_value != 0);
+}
+
+std::size_t BitWriter::flush()
+{
+	if (scratchBits > 0) {
+		write(0, 8 - scratchBits);
+	}
+	return bytes;
+}
+
+BitReader::BitReader(const char* _data, std::size_t _size) :
+	data(_data),
+	size(_size)
+{
+}
+
+std::uint32_t BitReader::read(int _bits)
+{
+	if (bitPosition + _bits > size * 8) {
+		failure = true;
+		bitPosition = size * 8;
+		return 0;
+	}
+
+	std::uint64_t value = 0;
+	int gathered = 0;
+	while (gathered < _bits) {
+		std::size_t byte = bitPosition / 8;
+		int offset = static_cast<int>(bitPosition % 8);
+		int take = (8 - offset) < (_bits - gathered) ? (8 - offset) : (_bits - gathered);
+
+		std::uint64_t bits = (static_cast<std::uint8_t>(data[byte]) >> offset) & ((1u << take) - 1);
+		value |= bits << gathered;
+
+		gathered += take;
+		bitPosition += take;
+	}
+	return static_cast<std::uint32_t>(value);
+}
+
+std::uint32_t BitReader::readVarUint()
+{
+	std::uint32_t value = 0;
+	for (int shift = 0; shift < 32; shift += 4) {
+		std::uint32_t chunk = read(5);
+		value |= (chunk & 0xF) << shift;
+		if ((chunk & 0x10) == 0) {
+			return value;
+		}
+	}
+	failure = true; //more than 32 bits of value
+	return 0;
+}
+
+bool BitReader::atEnd() const
+{
+	if (size * 8 - bitPosition >= 8) {
+		return false; //a whole unread byte means the sender wrote more than we read
+	}
+	return bitPosition % 8 == 0 || (static_cast<std::uint8_t>(data[size - 1]) >> (bitPosition % 8)) == 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// maps a float range onto an unsigned value of a set number of bits, values outside the range are clamped
+/// </summary>
+struct Quantization
+{
+	float min;
+	float max;
+	int bits;
+
+	std::uint32_t quantize(float _value) const;
+	float dequantize(std::uint32_t _value) const;
+	float step() const { return (max - min) / static_cast<float>(maxValue()); } //smallest difference that survives
+	std::uint32_t maxValue() const { return bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1; }
+};
+
+/// <summary>
+/// packs values of any bit width back to back into a byte buffer, lowest bits first
+/// nothing is written past the capacity, overflowed() reports if that was needed
+/// </summary>
+class BitWriter
+{
+public:
+	BitWriter(char* _data, std::size_t _capacity);
+
+	void write(std::uint32_t _value, int _bits); //low _bits of _value, 1 to 32
+	void writeBool(bool _value) { write(_value ? 1u : 0u, 1); }
+	void writeVarUint(std::uint32_t _value); //4 bits and a continue bit at a time, small numbers stay small
+
+	std::size_t flush(); //pads to a whole byte, returns total bytes written
+	bool overflowed() const { return overflow; }
+
+private:
+	char* data;
+	std::size_t capacity;
+	std::size_t bytes = 0; //whole bytes already in data
+
+	std::uint64_t scratch = 0; //bits not yet moved into data
+	int scratchBits = 0;
+
+	bool overflow = false;
+};
+
+/// <summary>
+/// reads back what a BitWriter wrote, reading past the end returns zeros and sets failed()
+/// so a whole message can be read before checking once
+/// </summary>
+class BitReader
+{
+public:
+	BitReader(const char* _data, std::size_t _size);
+
+	std::uint32_t read(int _bits); //1 to 32
+	bool readBool() { return read(1) != 0; }
+	std::uint32_t readVarUint();
+
+	bool failed() const { return failure; }
+	bool atEnd() const; //only zero padding is left
+
+private:
+	const char* data;
+	std::size_t size;
+	std::size_t bitPosition = 0;
+
+	bool failure = false;
+};
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// appends whole values to a growing byte buffer in host order, for files written and read on the same kind of machine
+/// </summary>
+class ByteWriter
+{
+public:
+	explicit ByteWriter(std::vector<char>& _out) : out(_out) {}
+
+	template<typename T>
+	void write(const T& _value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "only plain values are written as bytes");
+		const char* bytes = reinterpret_cast<const char*>(&_value);
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	void writeBytes(const char* _data, std::size_t _size) { out.insert(out.end(), _data, _data + _size); }
+
+	void writeVarUint(std::uint64_t _value) //7 bits and a continue bit at a time
+	{
+		while (_value >= 0x80) {
+			out.push_back(static_cast<char>((_value & 0x7F) | 0x80));
+			_value >>= 7;
+		}
+		out.push_back(static_cast<char>(_value));
+	}
+
+	std::size_t size() const { return out.size(); }
+
+private:
+	std::vector<char>& out;
+};
+
+/// <summary>
+/// reads back what a ByteWriter wrote, reading past the end returns zeros and sets failed()
+/// so a whole record can be read before checking once
+/// </summary>
+class ByteReader
+{
+public:
+	ByteReader(const char* _data, std::size_t _size) : data(_data), size(_size) {}
+
+	template<typename T>
+	T read()
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "only plain values are read as bytes");
+		T value{};
+		if (sizeof(T) > size - position) {
+			failure = true;
+			position = size;
+			return value;
+		}
+		std::memcpy(&value, data + position, sizeof(T));
+		position += sizeof(T);
+		return value;
+	}
+
+	const char* readBytes(std::size_t _size) //nullptr if there are not that many left
+	{
+		if (_size > size - position) {
+			failure = true;
+			position = size;
+			return nullptr;
+		}
+		const char* bytes = data + position;
+		position += _size;
+		return bytes;
+	}
+
+	std::uint64_t readVarUint()
+	{
+		std::uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (position >= size) {
+				failure = true;
+				return 0;
+			}
+			std::uint8_t byte = static_cast<std::uint8_t>(data[position++]);
+			value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) {
+				return value;
+			}
+		}
+		failure = true; //longer than any 64 bit value
+		return 0;
+	}
+
+	bool failed() const { return failure; }
+	std::size_t getPosition() const { return position; }
+	std::size_t remaining() const { return size - position; }
+
+private:
+	const char* data;
+	std::size_t size;
+	std::size_t position = 0;
+
+	bool failure = false;
+};
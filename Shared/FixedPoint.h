@@ -0,0 +1,49 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+/// <summary>
+/// 16.16 fixed point number, everything the simulation does with it is integer math
+/// so the same inputs give the same bits on every machine, compiler and optimisation level
+/// floats only come in from outside the simulation and go out to be drawn or quantized
+/// </summary>
+struct Fixed
+{
+	static const int FRACTION_BITS = 16;
+	static const std::int32_t ONE = std::int32_t{ 1 } << FRACTION_BITS;
+
+	std::int32_t raw = 0;
+
+	static constexpr Fixed fromRaw(std::int32_t _raw) { Fixed value; value.raw = _raw; return value; }
+	static constexpr Fixed fromInt(std::int32_t _value) { return fromRaw(_value * ONE); }
+	static constexpr Fixed fromFloat(float _value) //nearest, for constants and values handed in from outside
+	{
+		return fromRaw(static_cast<std::int32_t>(_value * ONE + (_value < 0.f ? -0.5f : 0.5f)));
+	}
+
+	float toFloat() const { return static_cast<float>(raw) / ONE; }
+	std::int32_t floorToInt() const { return raw >> FRACTION_BITS; } //arithmetic shift, rounds towards minus infinity
+
+	constexpr Fixed operator-() const { return fromRaw(-raw); }
+	constexpr Fixed operator+(Fixed _other) const { return fromRaw(raw + _other.raw); }
+	constexpr Fixed operator-(Fixed _other) const { return fromRaw(raw - _other.raw); }
+	constexpr Fixed operator*(std::int32_t _scale) const { return fromRaw(raw * _scale); }
+	Fixed& operator+=(Fixed _other) { raw += _other.raw; return *this; }
+	Fixed& operator-=(Fixed _other) { raw -= _other.raw; return *this; }
+
+	constexpr bool operator==(Fixed _other) const { return raw == _other.raw; }
+	constexpr bool operator!=(Fixed _other) const { return raw != _other.raw; }
+	constexpr bool operator<(Fixed _other) const { return raw < _other.raw; }
+	constexpr bool operator>(Fixed _other) const { return raw > _other.raw; }
+	constexpr bool operator<=(Fixed _other) const { return raw <= _other.raw; }
+	constexpr bool operator>=(Fixed _other) const { return raw >= _other.raw; }
+};
+
+/// <summary>
+/// squared length of a vector kept as 32.32 in 64 bits, enough for any distance across the world,
+/// compared against another squared length so no square root or division is needed
+/// </summary>
+constexpr std::int64_t squaredLength(Fixed _x, Fixed _y)
+{
+	return static_cast<std::int64_t>(_x.raw) * _x.raw + static_cast<std::int64_t>(_y.raw) * _y.raw;
+}
@@ -0,0 +1,157 @@
+#include "MatchRecording.h"
+#include <iostream>
+
+/// <summary>
+/// the config is written whole, a replay has to step with exactly the rates and delays the match had
+/// </summary>
+void writeRecordingHeader(std::vector<char>& _out, const SimulationConfig& _config)
+{
+	ByteWriter writer(_out);
+	writer.writeBytes(MATCH_RECORDING_MAGIC, sizeof(MATCH_RECORDING_MAGIC));
+	writer.write(MATCH_RECORDING_VERSION);
+	writer.write<std::int32_t>(_config.tickRate);
+	writer.write<std::int32_t>(_config.maxPlayers);
+	writer.write(_config.pickUpDelay);
+	writer.write(_config.invisibilityDuration);
+	writer.write(_config.gameOverDelay);
+	writer.write(_config.maxRewind);
+	writer.write(_config.seed);
+}
+
+bool readRecordingHeader(ByteReader& _in, SimulationConfig& _config)
+{
+	const char* magic = _in.readBytes(sizeof(MATCH_RECORDING_MAGIC));
+	if (magic == nullptr || std::memcmp(magic, MATCH_RECORDING_MAGIC, sizeof(MATCH_RECORDING_MAGIC)) != 0) {
+		return false;
+	}
+	if (_in.read<std::uint16_t>() != MATCH_RECORDING_VERSION) {
+		return false;
+	}
+	_config.tickRate = _in.read<std::int32_t>();
+	_config.maxPlayers = _in.read<std::int32_t>();
+	_config.pickUpDelay = _in.read<float>();
+	_config.invisibilityDuration = _in.read<float>();
+	_config.gameOverDelay = _in.read<float>();
+	_config.maxRewind = _in.read<float>();
+	_config.seed = _in.read<std::uint64_t>();
+	return !_in.failed() && _config.tickRate > 0 && _config.maxPlayers > 0;
+}
+
+bool RecordCursor::next(Record& _record)
+{
+	if (position >= size) {
+		return false;
+	}
+	ByteReader reader(data + position, size - position);
+	std::uint8_t type = reader.read<std::uint8_t>();
+	std::uint64_t payloadSize = reader.readVarUint();
+	if (reader.failed() || type < static_cast<std::uint8_t>(RecordType::Join) || type > static_cast<std::uint8_t>(RecordType::Keyframe) ||
+		payloadSize > reader.remaining()) {
+		return false; //cut off or damaged, everything before it still replays
+	}
+	_record.type = static_cast<RecordType>(type);
+	_record.offset = position;
+	_record.payload = data + position + reader.getPosition();
+	_record.size = static_cast<std::size_t>(payloadSize);
+	position += reader.getPosition() + _record.size;
+	return true;
+}
+
+MatchRecorder::~MatchRecorder()
+{
+	close();
+}
+
+bool MatchRecorder::open(const std::string& _path, const SimulationConfig& _config)
+{
+	file.open(_path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		std::cerr << "Could not create recording " << _path << "\n";
+		return false;
+	}
+	keyframeInterval = static_cast<std::uint64_t>(_config.tickRate) * KEYFRAME_SECONDS;
+	lastState = MatchState::Playing;
+	buffer.clear();
+	writeRecordingHeader(buffer, _config);
+	flush();
+	return true;
+}
+
+void MatchRecorder::close()
+{
+	if (file.is_open()) {
+		flush();
+		file.close();
+	}
+}
+
+void MatchRecorder::playerJoined(int _id)
+{
+	ByteWriter(scratch).write<std::int32_t>(_id);
+	append(RecordType::Join);
+}
+
+void MatchRecorder::playerLeft(int _id)
+{
+	ByteWriter(scratch).write<std::int32_t>(_id);
+	append(RecordType::Leave);
+}
+
+void MatchRecorder::input(int _playerID, int _xDir, int _yDir, std::uint64_t _viewTick)
+{
+	ByteWriter writer(scratch);
+	writer.write<std::int32_t>(_playerID);
+	writer.write<std::int8_t>(static_cast<std::int8_t>(_xDir)); //clients send single bytes, nothing is lost
+	writer.write<std::int8_t>(static_cast<std::int8_t>(_yDir));
+	writer.write<std::uint32_t>(static_cast<std::uint32_t>(_viewTick));
+	append(RecordType::Input);
+}
+
+/// <summary>
+/// a step is two bytes, a keyframe is written after the step it describes so seeking lands between steps
+/// </summary>
+void MatchRecorder::stepped(const Simulation& _simulation)
+{
+	if (!file.is_open()) {
+		return;
+	}
+	ByteWriter writer(scratch);
+	append(RecordType::Step);
+
+	if (_simulation.getState() != lastState) {
+		lastState = _simulation.getState();
+		writer.write<std::uint8_t>(lastState == MatchState::GameOver ? 1 : 0);
+		writer.write<std::uint32_t>(static_cast<std::uint32_t>(_simulation.getSurvivalTime() * 1000.f));
+		append(RecordType::Transition);
+	}
+
+	if (_simulation.getTick() % keyframeInterval == 0) {
+		writer.write(_simulation.getTick());
+		_simulation.saveState(writer);
+		append(RecordType::Keyframe);
+		flush(); //a crash loses at most the records since the last keyframe
+	}
+}
+
+void MatchRecorder::append(RecordType _type)
+{
+	if (!file.is_open()) {
+		scratch.clear();
+		return;
+	}
+	ByteWriter writer(buffer);
+	writer.write(static_cast<std::uint8_t>(_type));
+	writer.writeVarUint(scratch.size());
+	writer.writeBytes(scratch.data(), scratch.size());
+	scratch.clear();
+	if (buffer.size() >= FLUSH_SIZE) {
+		flush();
+	}
+}
+
+void MatchRecorder::flush()
+{
+	file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	file.flush();
+	buffer.clear();
+}
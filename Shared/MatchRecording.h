@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "ByteStream.h"
+#include "Simulation.h"
+
+/// <summary>
+/// match recordings are a header followed by records, each a type byte, a varint payload size and the payload
+/// a record that does not parse ends the recording, so a host that died mid write leaves a usable file
+///
+/// between steps: Join, Leave and Input in the order the room handed them to the simulation
+/// each step: Step, then Transition if the match state changed,
+/// then Keyframe every so often with the whole simulation state so a replay can start anywhere
+/// </summary>
+const char MATCH_RECORDING_MAGIC[4] = { 'T', 'A', 'G', 'R' };
+const std::uint16_t MATCH_RECORDING_VERSION = 3; //2 keeps the seed instead of every draw, 3 keyframes keep inputs carried to later ticks
+
+enum class RecordType : std::uint8_t
+{
+	Join = 1, //player id the simulation handed out
+	Leave, //player id
+	Input, //player id, x and y direction, view tick
+	Step, //empty, the match's generator is seeded from the header
+	Transition, //new match state, survival time in milliseconds
+	Keyframe //tick, then Simulation::saveState
+};
+
+struct RecordedInput
+{
+	std::int32_t playerID;
+	std::int8_t xDir;
+	std::int8_t yDir;
+	std::uint32_t viewTick;
+};
+
+void writeRecordingHeader(std::vector<char>& _out, const SimulationConfig& _config);
+bool readRecordingHeader(ByteReader& _in, SimulationConfig& _config); //false if not a recording or from another version
+
+/// one record as found in a recording, the payload points into the recording
+struct Record
+{
+	RecordType type;
+	const char* payload;
+	std::size_t size;
+	std::size_t offset; //of the type byte from the start of the recording
+};
+
+/// <summary>
+/// walks the records of a recording held in memory, usually a mapped file
+/// </summary>
+class RecordCursor
+{
+public:
+	RecordCursor(const char* _data, std::size_t _size, std::size_t _firstRecord) : data(_data), size(_size), position(_firstRecord) {}
+
+	bool next(Record& _record); //false at the end or at the first damaged record
+	void seek(std::size_t _offset) { position = _offset; } //to a record offset found earlier
+	std::size_t getPosition() const { return position; }
+
+private:
+	const char* data;
+	std::size_t size;
+	std::size_t position;
+};
+
+/// <summary>
+/// appends one room's match to a recording as it is played, records gather in memory and reach the file
+/// in large writes, at keyframes and when closed, so recording costs the tick a few copies
+/// </summary>
+class MatchRecorder
+{
+public:
+	MatchRecorder() = default;
+	~MatchRecorder();
+
+	MatchRecorder(const MatchRecorder&) = delete;
+	MatchRecorder& operator=(const MatchRecorder&) = delete;
+
+	bool open(const std::string& _path, const SimulationConfig& _config); //false if the file could not be created
+	bool isOpen() const { return file.is_open(); }
+	void close();
+
+	//call in the order they are handed to the simulation
+	void playerJoined(int _id);
+	void playerLeft(int _id);
+	void input(int _playerID, int _xDir, int _yDir, std::uint64_t _viewTick);
+
+	void stepped(const Simulation& _simulation); //after each step, marks it and writes any transition or keyframe
+
+	static const int KEYFRAME_SECONDS = 10; //replays seek to the keyframe before a tick and step from there
+
+private:
+	void append(RecordType _type); //scratch becomes the payload
+	void flush();
+
+	std::ofstream file;
+	std::vector<char> buffer; //records not yet written
+	std::vector<char> scratch; //payload of the record being built
+	std::uint64_t keyframeInterval = 0; //ticks
+	MatchState lastState = MatchState::Playing;
+
+	static const std::size_t FLUSH_SIZE = 64 * 1024;
+};
@@ -0,0 +1,174 @@
+#include "MetricsServer.h"
+#include <iostream>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+namespace
+{
+	const int ACCEPT_WAIT_MS = 200; //how quickly stop is noticed
+	const int REQUEST_WAIT_MS = 1000; //a scraper that sends nothing for this long is hung up on
+	const std::size_t MAX_REQUEST = 4096;
+
+	/// <summary>
+	/// waits for a socket to become readable
+	/// </summary>
+	/// <returns>false on a timeout or error</returns>
+	bool waitReadable(SocketHandle _socket, int _timeoutMs)
+	{
+		pollfd entry{};
+		entry.fd = _socket;
+		entry.events = POLLIN;
+#ifdef _WIN32
+		return WSAPoll(&entry, 1, _timeoutMs) > 0;
+#else
+		return ::poll(&entry, 1, _timeoutMs) > 0;
+#endif
+	}
+
+	void sendAll(SocketHandle _socket, const std::string& _data)
+	{
+		std::size_t sent = 0;
+		while (sent < _data.size()) {
+			int result = sendBytes(_socket, _data.data() + sent, _data.size() - sent);
+			if (result <= 0) {
+				return; //scraper went away
+			}
+			sent += static_cast<std::size_t>(result);
+		}
+	}
+}
+
+MetricsText::MetricsText()
+{
+	out.precision(9); //sums of microsecond phases over days still show the microseconds
+}
+
+void MetricsText::describe(const char* _name, const char* _type, const char* _help)
+{
+	out << "# HELP " << _name << " " << _help << "\n";
+	out << "# TYPE " << _name << " " << _type << "\n";
+}
+
+void MetricsText::sample(const char* _name, const std::string& _labels, double _value)
+{
+	out << _name;
+	if (!_labels.empty()) {
+		out << "{" << _labels << "}";
+	}
+	out << " " << _value << "\n";
+}
+
+void MetricsText::sample(const char* _name, const std::string& _labels, std::uint64_t _value)
+{
+	out << _name;
+	if (!_labels.empty()) {
+		out << "{" << _labels << "}";
+	}
+	out << " " << _value << "\n";
+}
+
+/// <summary>
+/// prometheus buckets are cumulative, every bucket counts everything at or under its bound
+/// </summary>
+void MetricsText::histogram(const char* _name, const std::string& _labels, const DurationHistogram& _histogram)
+{
+	std::string separator = _labels.empty() ? "" : ",";
+	std::uint64_t cumulative = 0;
+	for (std::size_t i = 0; i < DurationHistogram::BUCKETS; ++i) {
+		cumulative += _histogram.getBucket(i);
+		out << _name << "_bucket{" << _labels << separator << "le=\"" << DurationHistogram::BOUNDS[i] << "\"} " << cumulative << "\n";
+	}
+	out << _name << "_bucket{" << _labels << separator << "le=\"+Inf\"} " << _histogram.getCount() << "\n";
+
+	std::string suffixLabels = _labels.empty() ? "" : "{" + _labels + "}";
+	out << _name << "_sum" << suffixLabels << " " << _histogram.getSum() << "\n";
+	out << _name << "_count" << suffixLabels << " " << _histogram.getCount() << "\n";
+}
+
+MetricsServer::~MetricsServer()
+{
+	stop();
+}
+
+/// <summary>
+/// binds loopback only, the numbers say a lot about the players and nothing outside the machine needs them
+/// </summary>
+/// <returns>false if the port could not be bound</returns>
+bool MetricsServer::start(unsigned short _port)
+{
+	listener = openListener(_port, true);
+	if (listener == INVALID_SOCKET_HANDLE) {
+		return false;
+	}
+	running = true;
+	thread = std::thread(&MetricsServer::run, this);
+	std::cout << "Metrics on http://127.0.0.1:" << _port << "/metrics" << "\n";
+	return true;
+}
+
+void MetricsServer::stop()
+{
+	running = false;
+	if (thread.joinable()) {
+		thread.join();
+	}
+	if (listener != INVALID_SOCKET_HANDLE) {
+		closeSocket(listener);
+		listener = INVALID_SOCKET_HANDLE;
+	}
+}
+
+void MetricsServer::publish(std::string _page)
+{
+	std::lock_guard<std::mutex> lock(pageMutex);
+	page.swap(_page); //the old page is freed by the caller, outside the lock
+}
+
+void MetricsServer::run()
+{
+	while (running) {
+		if (!waitReadable(listener, ACCEPT_WAIT_MS)) {
+			continue;
+		}
+		SocketHandle client = accept(listener, nullptr, nullptr);
+		if (client != INVALID_SOCKET_HANDLE) {
+			serve(client);
+			closeSocket(client);
+		}
+	}
+}
+
+/// <summary>
+/// reads up to the end of the request head, only GET /metrics is answered with the page
+/// </summary>
+void MetricsServer::serve(SocketHandle _client)
+{
+	std::string request;
+	char buffer[1024];
+	while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST) {
+		if (!waitReadable(_client, REQUEST_WAIT_MS)) {
+			return;
+		}
+		int received = receiveBytes(_client, buffer, sizeof(buffer));
+		if (received <= 0) {
+			return;
+		}
+		request.append(buffer, static_cast<std::size_t>(received));
+	}
+
+	if (request.compare(0, 13, "GET /metrics ") != 0 && request.compare(0, 6, "GET / ") != 0) {
+		sendAll(_client, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+		return;
+	}
+
+	std::string body;
+	{
+		std::lock_guard<std::mutex> lock(pageMutex);
+		body = page;
+	}
+	sendAll(_client, "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(body.size()) +
+		"\r\nConnection: close\r\n\r\n");
+	sendAll(_client, body);
+}
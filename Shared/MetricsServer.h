@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "Socket.h"
+#include "TickProfiler.h"
+
+/// <summary>
+/// builds a page in the prometheus text format, each metric gets its help and type line once
+/// before its samples, labels are passed already formatted as name="value",...
+/// </summary>
+class MetricsText
+{
+public:
+	MetricsText();
+
+	void describe(const char* _name, const char* _type, const char* _help);
+	void sample(const char* _name, const std::string& _labels, double _value);
+	void sample(const char* _name, const std::string& _labels, std::uint64_t _value);
+	void histogram(const char* _name, const std::string& _labels, const DurationHistogram& _histogram); //buckets, sum and count
+
+	std::string take() { return out.str(); }
+
+private:
+	std::ostringstream out;
+};
+
+/// <summary>
+/// serves the newest published page over http on its own thread, bound to loopback only
+/// the tick thread renders and publishes, a scrape never waits on a tick or a tick on a scrape
+/// </summary>
+class MetricsServer
+{
+public:
+	MetricsServer() = default;
+	~MetricsServer();
+
+	MetricsServer(const MetricsServer&) = delete;
+	MetricsServer& operator=(const MetricsServer&) = delete;
+
+	bool start(unsigned short _port); //false if the port could not be bound
+	void stop();
+	bool isRunning() const { return running; }
+
+	void publish(std::string _page); //replaces what the next scrape gets, safe from any thread
+
+private:
+	void run();
+	void serve(SocketHandle _client); //answers one request and closes
+
+	SocketHandle listener = INVALID_SOCKET_HANDLE;
+	std::thread thread;
+	std::atomic<bool> running = false;
+
+	std::mutex pageMutex; //guards page
+	std::string page;
+};
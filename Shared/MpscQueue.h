@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/// <summary>
+/// bounded ring that any number of threads push into and one thread pops from, without locks
+/// every cell carries a sequence number that says whose turn it is, producers claim a cell
+/// by moving the shared enqueue position on and publish it by bumping the cells sequence
+/// </summary>
+template <typename T>
+class MpscQueue
+{
+public:
+	explicit MpscQueue(std::size_t _capacity) //rounded up to a power of two
+	{
+		std::size_t size = 2;
+		while (size < _capacity) {
+			size *= 2;
+		}
+		mask = size - 1;
+		cells = std::make_unique<Cell[]>(size);
+		for (std::size_t i = 0; i < size; ++i) {
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	/// <summary>
+	/// safe from any thread
+	/// </summary>
+	/// <returns>false if the queue is full, nothing is written</returns>
+	bool tryPush(const T& _value)
+	{
+		std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true)
+		{
+			cell = &cells[position & mask];
+			std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t lag = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+			if (lag == 0) {
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					break; //cell is ours
+				}
+			}
+			else if (lag < 0) {
+				return false; //the consumer has not emptied this cell from the last lap
+			}
+			else {
+				position = enqueuePosition.load(std::memory_order_relaxed); //another producer took it
+			}
+		}
+		cell->value = _value;
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// consumer thread only
+	/// </summary>
+	/// <returns>false if nothing has been published yet</returns>
+	bool tryPop(T& _out)
+	{
+		Cell& cell = cells[dequeuePosition & mask];
+		if (cell.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+			return false;
+		}
+		_out = cell.value;
+		cell.sequence.store(dequeuePosition + mask + 1, std::memory_order_release); //free for the next lap
+		++dequeuePosition;
+		return true;
+	}
+
+	std::size_t capacity() const { return mask + 1; }
+	std::size_t size() const { return enqueuePosition.load(std::memory_order_relaxed) - dequeuePosition; } //consumer thread only, counts pushes still being written
+
+private:
+	struct Cell
+	{
+		std::atomic<std::size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	std::size_t mask = 0;
+
+	alignas(64) std::atomic<std::size_t> enqueuePosition = 0; //shared by the producers
+	alignas(64) std::size_t dequeuePosition = 0; //consumer only, kept off the producers cache line
+};
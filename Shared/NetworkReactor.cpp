@@ -0,0 +1,580 @@
+#include "NetworkReactor.h"
+#include <iostream>
+
+#ifdef REACTOR_USE_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+NetworkReactor::NetworkReactor()
+{
+#ifdef REACTOR_USE_EPOLL
+	epollHandle = epoll_create1(0);
+	if (epollHandle < 0) {
+		std::cerr << "epoll_create1 failed: " << lastSocketError() << "\n";
+	}
+#endif
+}
+
+NetworkReactor::~NetworkReactor()
+{
+	for (auto& [id, connection] : connections) {
+		closeSocket(connection->socket);
+	}
+	if (listener != INVALID_SOCKET_HANDLE) {
+		closeSocket(listener);
+	}
+	if (datagramSocket != INVALID_SOCKET_HANDLE) {
+		closeSocket(datagramSocket);
+	}
+#ifdef REACTOR_USE_EPOLL
+	if (epollHandle >= 0) {
+		close(epollHandle);
+	}
+#endif
+}
+
+void NetworkReactor::setHandlers(AcceptHandler _onAccept, MessageHandler _onMessage, CloseHandler _onClose)
+{
+	onAccept = std::move(_onAccept);
+	onMessage = std::move(_onMessage);
+	onClose = std::move(_onClose);
+}
+
+/// <summary>
+/// opens the listener and starts watching it for new connections
+/// </summary>
+bool NetworkReactor::listen(unsigned short _port)
+{
+	listener = openListener(_port);
+	if (listener == INVALID_SOCKET_HANDLE) {
+		return false;
+	}
+	setNonBlocking(listener, true); //accept until it would block
+	watch(listener, LISTENER_KEY);
+	return true;
+}
+
+/// <summary>
+/// opens the udp socket and starts watching it, every datagram is split into messages for the handler
+/// </summary>
+bool NetworkReactor::openDatagram(unsigned short _port, DatagramHandler _onDatagram)
+{
+	datagramSocket = openDatagramSocket(_port);
+	if (datagramSocket == INVALID_SOCKET_HANDLE) {
+		return false;
+	}
+	onDatagram = std::move(_onDatagram);
+	watch(datagramSocket, DATAGRAM_KEY);
+	return true;
+}
+
+void NetworkReactor::run()
+{
+	running = true;
+	while (running) {
+		poll(50); //short wait so stop is noticed quickly
+	}
+}
+
+void NetworkReactor::stop()
+{
+	running = false;
+}
+
+/// <summary>
+/// waits for any socket to be ready then accepts, reads and dispatches
+/// </summary>
+void NetworkReactor::poll(int _timeoutMs)
+{
+#ifdef REACTOR_USE_EPOLL
+	epoll_event events[64];
+	int ready = epoll_wait(epollHandle, events, 64, _timeoutMs);
+
+	for (int i = 0; i < ready; ++i) {
+		if (events[i].data.u64 == LISTENER_KEY) {
+			acceptPending();
+		}
+		else if (events[i].data.u64 == DATAGRAM_KEY) {
+			readDatagrams();
+		}
+		else {
+			ConnectionID id = static_cast<ConnectionID>(events[i].data.u64);
+			if (events[i].events & EPOLLOUT) {
+				writeConnection(id);
+			}
+			if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+				readConnection(id); //a reset shows up as a failed read
+			}
+		}
+	}
+#else
+	pollSet.clear();
+	pollOwners.clear();
+	pollSet.push_back({ listener, POLLIN, 0 });
+	pollOwners.push_back(LISTENER_KEY);
+	if (datagramSocket != INVALID_SOCKET_HANDLE) {
+		pollSet.push_back({ datagramSocket, POLLIN, 0 });
+		pollOwners.push_back(DATAGRAM_KEY);
+	}
+	{
+		std::lock_guard<std::mutex> lock(connectionsMutex);
+		for (auto& [id, connection] : connections) {
+			short interest = connection->wantsWrite ? POLLIN | POLLOUT : POLLIN;
+			pollSet.push_back({ connection->socket, interest, 0 });
+			pollOwners.push_back(id);
+		}
+	}
+
+#ifdef _WIN32
+	int ready = WSAPoll(pollSet.data(), static_cast<ULONG>(pollSet.size()), _timeoutMs);
+#else
+	int ready = ::poll(pollSet.data(), pollSet.size(), _timeoutMs);
+#endif
+
+	for (std::size_t i = 0; ready > 0 && i < pollSet.size(); ++i) {
+		if (pollSet[i].revents == 0) {
+			continue;
+		}
+		--ready;
+		if (pollOwners[i] == LISTENER_KEY) {
+			acceptPending();
+		}
+		else if (pollOwners[i] == DATAGRAM_KEY) {
+			readDatagrams();
+		}
+		else {
+			ConnectionID id = static_cast<ConnectionID>(pollOwners[i]);
+			if (pollSet[i].revents & POLLOUT) {
+				writeConnection(id);
+			}
+			if (pollSet[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+				readConnection(id);
+			}
+		}
+	}
+#endif
+
+	evictStalled();
+	closePending();
+}
+
+/// <summary>
+/// writes the pieces straight to the socket in one gathered call when nothing is queued ahead,
+/// only what the socket will not take yet is copied into the connections queue
+/// </summary>
+bool NetworkReactor::send(ConnectionID _connection, const ConstBuffer* _buffers, std::size_t _count, std::size_t _replaceableFrom)
+{
+	std::shared_ptr<Connection> connection = findConnection(_connection);
+	if (!connection) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(connection->sendMutex); //only this connection, other senders carry on
+	if (connection->closing) {
+		return false;
+	}
+
+	std::size_t total = 0;
+	std::size_t replaceableOffset = 0; //where the replaceable message starts among all the bytes
+	for (std::size_t i = 0; i < _count; ++i) {
+		if (i == _replaceableFrom) {
+			replaceableOffset = total;
+		}
+		total += _buffers[i].size;
+	}
+	bool replaceable = _replaceableFrom < _count;
+
+	std::size_t written = 0;
+	if (connection->outbound.empty()) {
+		std::size_t first = 0; //first piece not wholly written
+		std::size_t skip = 0; //bytes of it already written
+		while (written < total) {
+			ConstBuffer pieces[MAX_SEND_BUFFERS];
+			std::size_t count = 0;
+			for (std::size_t i = first; i < _count && count < MAX_SEND_BUFFERS; ++i) {
+				std::size_t offset = i == first ? skip : 0;
+				pieces[count++] = ConstBuffer{ _buffers[i].data + offset, _buffers[i].size - offset };
+			}
+
+			int result = sendBuffers(connection->socket, pieces, count);
+			if (result > 0) {
+				written += result;
+				std::size_t advance = result;
+				while (advance > 0) {
+					std::size_t left = _buffers[first].size - skip;
+					if (advance < left) {
+						skip += advance;
+						break;
+					}
+					advance -= left;
+					++first;
+					skip = 0;
+				}
+			}
+			else if (result < 0 && isWouldBlock(lastSocketError())) {
+				break; //socket buffer is full, queue the rest
+			}
+			else {
+				scheduleClose(_connection, *connection);
+				return false;
+			}
+		}
+		if (written == total) {
+			return true; //the usual case, nothing queued
+		}
+		connection->lastProgress = Clock::now();
+		replaceable = replaceable && written <= replaceableOffset; //half a message on the wire has to be finished
+	}
+	else if (replaceable && connection->replaceableStart != NOTHING_REPLACEABLE && connection->replaceableStart >= connection->outboundSent) {
+		auto start = connection->outbound.begin() + connection->replaceableStart;
+		connection->outbound.erase(start, start + connection->replaceableSize); //nobody needs the older one now
+		++superseded;
+	}
+
+	if (replaceable) {
+		connection->replaceableStart = connection->outbound.size() + (replaceableOffset - written);
+		connection->replaceableSize = total - replaceableOffset;
+	}
+	std::size_t position = 0;
+	for (std::size_t i = 0; i < _count; ++i) {
+		std::size_t end = position + _buffers[i].size;
+		if (end > written) {
+			std::size_t offset = written > position ? written - position : 0;
+			connection->outbound.insert(connection->outbound.end(), _buffers[i].data + offset, _buffers[i].data + _buffers[i].size);
+		}
+		position = end;
+	}
+
+	std::size_t queued = connection->outbound.size() - connection->outboundSent;
+	if (queued > limits.budget) {
+		std::cerr << "Connection " << _connection << " is " << queued << " bytes behind, dropping." << "\n";
+		++evicted;
+		scheduleClose(_connection, *connection);
+		return false;
+	}
+	if (!connection->wantsWrite) {
+		setWriteInterest(_connection, *connection, true);
+	}
+	return true;
+}
+
+void NetworkReactor::disconnect(ConnectionID _connection)
+{
+	std::shared_ptr<Connection> connection = findConnection(_connection);
+	if (!connection) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(connection->sendMutex);
+	if (!connection->closing) {
+		scheduleClose(_connection, *connection);
+	}
+}
+
+/// <summary>
+/// one that fails is skipped so a single bad address does not cost everyone behind it their datagram
+/// </summary>
+std::size_t NetworkReactor::sendDatagrams(const OutgoingDatagram* _datagrams, std::size_t _count)
+{
+	std::size_t sent = 0;
+	std::size_t next = 0;
+	while (next < _count) {
+		int result = sendDatagramBatch(datagramSocket, _datagrams + next, _count - next);
+		if (result < 0) {
+			++next;
+			continue;
+		}
+		sent += result;
+		next += result;
+	}
+	return sent;
+}
+
+std::size_t NetworkReactor::queuedBytes(ConnectionID _connection) const
+{
+	std::shared_ptr<Connection> connection = findConnection(_connection);
+	if (!connection) {
+		return 0;
+	}
+	std::lock_guard<std::mutex> lock(connection->sendMutex);
+	return connection->outbound.size() - connection->outboundSent;
+}
+
+/// <summary>
+/// accepts everything waiting on the listener
+/// </summary>
+void NetworkReactor::acceptPending()
+{
+	while (true) {
+		SocketHandle clientSocket = accept(listener, nullptr, nullptr);
+		if (clientSocket == INVALID_SOCKET_HANDLE) {
+			int error = lastSocketError();
+			if (!isWouldBlock(error)) {
+				std::cerr << "Accept failed: " << error << "\n";
+			}
+			return;
+		}
+		setNonBlocking(clientSocket, true); //sends queue instead of waiting on a slow client
+		setNoDelay(clientSocket, true); //snapshots go out as soon as the tick writes them
+
+		ConnectionID id = nextConnectionID++;
+		{
+			std::lock_guard<std::mutex> lock(connectionsMutex);
+			auto connection = std::make_shared<Connection>();
+			connection->socket = clientSocket;
+			connections.emplace(id, std::move(connection));
+		}
+		watch(clientSocket, id);
+
+		if (onAccept) {
+			onAccept(id);
+		}
+	}
+}
+
+/// <summary>
+/// drains every waiting datagram, ones that dont decode are dropped whole
+/// </summary>
+void NetworkReactor::readDatagrams()
+{
+	char data[MAX_DATAGRAM_SIZE];
+	SocketAddress from{};
+
+	while (true) {
+		int received = receiveDatagram(datagramSocket, data, sizeof(data), from);
+		if (received <= 0) {
+			return; //would block, or an icmp error we cant act on
+		}
+
+		//validate the whole datagram before handing any of it on
+		if (!forEachMessage(data, received, [](const MessageHeader&, const char*) {})) {
+			continue;
+		}
+		if (onDatagram) {
+			forEachMessage(data, received, [this, &from](const MessageHeader& _header, const char* _payload) {
+				onDatagram(from, _header, _payload);
+			});
+		}
+	}
+}
+
+/// <summary>
+/// reads what is waiting on a connection and dispatches every whole message
+/// </summary>
+void NetworkReactor::readConnection(ConnectionID _connection)
+{
+	Connection* connection = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(connectionsMutex);
+		auto it = connections.find(_connection);
+		if (it == connections.end()) {
+			return;
+		}
+		connection = it->second.get(); //only this thread erases, so the pointer stays valid
+	}
+
+	StreamBuffer& stream = connection->stream;
+	int received = receiveBytes(connection->socket, stream.writePointer(), stream.writableBytes());
+
+	if (received > 0) {
+		stream.commitWrite(received);
+
+		MessageHeader header;
+		const char* payload = nullptr;
+		FrameStatus status;
+		while ((status = stream.nextFrame(header, payload)) == FrameStatus::Complete) {
+			if (onMessage) {
+				onMessage(_connection, header, payload);
+			}
+		}
+		if (status == FrameStatus::Malformed) {
+			std::cerr << "Malformed data from connection " << _connection << ", dropping." << "\n";
+			closeConnection(_connection);
+		}
+	}
+	else if (received == 0) {
+		std::cout << "Client disconnected." << "\n";
+		closeConnection(_connection);
+	}
+	else if (!isWouldBlock(lastSocketError())) {
+		std::cerr << "Recv failed: " << lastSocketError() << "\n";
+		closeConnection(_connection);
+	}
+}
+
+/// <summary>
+/// sends what is queued now the socket has room, stops watching for room once it is all gone
+/// </summary>
+void NetworkReactor::writeConnection(ConnectionID _connection)
+{
+	std::shared_ptr<Connection> connection = findConnection(_connection);
+	if (!connection) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(connection->sendMutex);
+	if (connection->closing) {
+		return;
+	}
+	if (!flushOutbound(*connection)) {
+		scheduleClose(_connection, *connection);
+	}
+	else if (connection->outbound.empty()) {
+		setWriteInterest(_connection, *connection, false);
+	}
+}
+
+/// <summary>
+/// stops the socket being used by senders before closing it, a sender may still hold the connection
+/// </summary>
+void NetworkReactor::closeConnection(ConnectionID _connection)
+{
+	std::shared_ptr<Connection> connection;
+	{
+		std::lock_guard<std::mutex> lock(connectionsMutex);
+		auto it = connections.find(_connection);
+		if (it == connections.end()) {
+			return;
+		}
+		connection = it->second;
+		connections.erase(it);
+	}
+	{
+		std::lock_guard<std::mutex> lock(connection->sendMutex);
+		unwatch(connection->socket);
+		closeSocket(connection->socket);
+		connection->closing = true; //the handle number may be reused from here on
+	}
+
+	if (onClose) {
+		onClose(_connection);
+	}
+}
+
+void NetworkReactor::closePending()
+{
+	std::vector<ConnectionID> closing;
+	{
+		std::lock_guard<std::mutex> lock(closeMutex);
+		closing.swap(pendingClose);
+	}
+	for (ConnectionID id : closing) {
+		closeConnection(id);
+	}
+}
+
+/// <summary>
+/// a client that is slow still takes some of its queue, one that takes nothing at all has gone away without saying
+/// </summary>
+void NetworkReactor::evictStalled()
+{
+	Clock::time_point now = Clock::now();
+	if (now < nextStallCheck) {
+		return;
+	}
+	nextStallCheck = now + std::chrono::milliseconds(100);
+
+	std::vector<std::pair<ConnectionID, std::shared_ptr<Connection>>> waiting;
+	{
+		std::lock_guard<std::mutex> lock(connectionsMutex);
+		for (auto& [id, connection] : connections) {
+			if (connection->wantsWrite) {
+				waiting.emplace_back(id, connection);
+			}
+		}
+	}
+	for (auto& [id, connection] : waiting)
+	{
+		std::lock_guard<std::mutex> lock(connection->sendMutex);
+		if (!connection->closing && !connection->outbound.empty() && now - connection->lastProgress > limits.stallTimeout) {
+			std::cerr << "Connection " << id << " has stopped reading, dropping." << "\n";
+			++evicted;
+			scheduleClose(id, *connection);
+		}
+	}
+}
+
+std::shared_ptr<NetworkReactor::Connection> NetworkReactor::findConnection(ConnectionID _connection) const
+{
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+	auto it = connections.find(_connection);
+	return it == connections.end() ? nullptr : it->second;
+}
+
+/// <summary>
+/// writes queued bytes until the socket is full, written bytes are only moved out once there are plenty of them
+/// </summary>
+bool NetworkReactor::flushOutbound(Connection& _connection)
+{
+	while (_connection.outboundSent < _connection.outbound.size()) {
+		int result = sendBytes(_connection.socket, _connection.outbound.data() + _connection.outboundSent, _connection.outbound.size() - _connection.outboundSent);
+		if (result > 0) {
+			_connection.outboundSent += result;
+			_connection.lastProgress = Clock::now();
+		}
+		else if (result < 0 && isWouldBlock(lastSocketError())) {
+			break;
+		}
+		else {
+			return false;
+		}
+	}
+
+	if (_connection.outboundSent == _connection.outbound.size()) {
+		_connection.outbound.clear(); //capacity is kept
+		_connection.outboundSent = 0;
+		_connection.replaceableStart = NOTHING_REPLACEABLE;
+	}
+	else if (_connection.outboundSent > 64 * 1024 && _connection.outboundSent * 2 > _connection.outbound.size()) {
+		_connection.outbound.erase(_connection.outbound.begin(), _connection.outbound.begin() + _connection.outboundSent);
+		if (_connection.replaceableStart != NOTHING_REPLACEABLE) {
+			_connection.replaceableStart = _connection.replaceableStart >= _connection.outboundSent ? _connection.replaceableStart - _connection.outboundSent : NOTHING_REPLACEABLE;
+		}
+		_connection.outboundSent = 0;
+	}
+	return true;
+}
+
+void NetworkReactor::scheduleClose(ConnectionID _id, Connection& _connection)
+{
+	_connection.closing = true;
+	std::lock_guard<std::mutex> lock(closeMutex);
+	pendingClose.push_back(_id);
+}
+
+/// <summary>
+/// watches for room in the socket buffer only while something is queued, otherwise every wait would wake at once
+/// </summary>
+void NetworkReactor::setWriteInterest(ConnectionID _id, Connection& _connection, bool _wanted)
+{
+	_connection.wantsWrite = _wanted;
+#ifdef REACTOR_USE_EPOLL
+	epoll_event event{};
+	event.events = _wanted ? EPOLLIN | EPOLLOUT : EPOLLIN;
+	event.data.u64 = _id;
+	epoll_ctl(epollHandle, EPOLL_CTL_MOD, _connection.socket, &event);
+#else
+	(void)_id; //picked up when the poll set is next rebuilt
+#endif
+}
+
+void NetworkReactor::watch(SocketHandle _socket, std::uint64_t _key)
+{
+#ifdef REACTOR_USE_EPOLL
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.u64 = _key;
+	epoll_ctl(epollHandle, EPOLL_CTL_ADD, _socket, &event);
+#else
+	(void)_socket; //poll set is rebuilt from the connection map every wait
+	(void)_key;
+#endif
+}
+
+void NetworkReactor::unwatch(SocketHandle _socket)
+{
+#ifdef REACTOR_USE_EPOLL
+	epoll_ctl(epollHandle, EPOLL_CTL_DEL, _socket, nullptr);
+#else
+	(void)_socket;
+#endif
+}
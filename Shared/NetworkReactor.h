@@ -0,0 +1,144 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Socket.h"
+#include "StreamBuffer.h"
+
+#ifdef __linux__
+#define REACTOR_USE_EPOLL 1 //poll is the fallback everywhere else
+#endif
+
+#ifndef REACTOR_USE_EPOLL
+#ifndef _WIN32
+#include <poll.h>
+#endif
+#endif
+
+using ConnectionID = std::uint32_t; //never reused, so a stale id just misses
+
+/// <summary>
+/// how much a client may fall behind before it is dropped
+/// </summary>
+struct SendLimits
+{
+	std::size_t budget = 256 * 1024; //unsent bytes a connection may have queued
+	std::chrono::milliseconds stallTimeout{ 3000 }; //longest a connection may have data queued without taking any of it
+};
+
+/// <summary>
+/// readiness based event loop that owns the listener and every client socket on one thread
+/// accepts connections, reassembles their streams and hands each decoded message to a handler
+/// sockets never block, what a client cannot take yet waits in its own queue and goes out when it becomes writable
+/// </summary>
+class NetworkReactor
+{
+public:
+	using AcceptHandler = std::function<void(ConnectionID)>;
+	using MessageHandler = std::function<void(ConnectionID, const MessageHeader&, const char*)>;
+	using CloseHandler = std::function<void(ConnectionID)>;
+	using DatagramHandler = std::function<void(const SocketAddress&, const MessageHeader&, const char*)>;
+
+	NetworkReactor();
+	~NetworkReactor();
+
+	/// <summary>
+	/// handlers run on the reactor thread, set them before run
+	/// </summary>
+	void setHandlers(AcceptHandler _onAccept, MessageHandler _onMessage, CloseHandler _onClose);
+
+	void setSendLimits(const SendLimits& _limits) { limits = _limits; } //before run
+
+	bool listen(unsigned short _port);
+	bool openDatagram(unsigned short _port, DatagramHandler _onDatagram); //udp beside the tcp listener
+
+	void run(); //waits and dispatches until stop is called
+	void stop();
+	void poll(int _timeoutMs); //one wait and dispatch
+
+	/// <summary>
+	/// writes what the socket will take now and queues the rest, never waits, safe from any thread
+	/// the pieces go back to back in one gathered call, so a client gets a whole tick in one syscall
+	/// the pieces from _replaceableFrom on are one replaceable message, _count or more means none are,
+	/// one still wholly queued is dropped when the next replaceable one is sent,
+	/// so a backed up client only ever has the newest snapshot waiting
+	/// </summary>
+	/// <returns>false if the connection is gone, closing, or was just dropped for falling too far behind</returns>
+	bool send(ConnectionID _connection, const ConstBuffer* _buffers, std::size_t _count, std::size_t _replaceableFrom);
+	void disconnect(ConnectionID _connection); //safe from any thread, closed on the next poll
+	std::size_t sendDatagrams(const OutgoingDatagram* _datagrams, std::size_t _count); //batched, safe from any thread, returns how many went
+
+	std::size_t queuedBytes(ConnectionID _connection) const; //written to its queue but not yet taken by the socket
+	std::uint64_t getSupersededCount() const { return superseded; } //replaceable messages dropped unsent
+	std::uint64_t getEvictedCount() const { return evicted; } //connections dropped for falling behind
+
+private:
+	using Clock = std::chrono::steady_clock;
+	static const std::size_t NOTHING_REPLACEABLE = static_cast<std::size_t>(-1);
+
+	struct Connection
+	{
+		SocketHandle socket = INVALID_SOCKET_HANDLE;
+		StreamBuffer stream; //only touched by the reactor thread
+
+		std::mutex sendMutex; //guards everything below, senders for different connections never wait on each other
+		bool closing = false; //checked by every sender before the socket is touched, its handle may be reused once closed
+		std::vector<char> outbound; //queued bytes, the first outboundSent of them are already written
+		std::size_t outboundSent = 0;
+		std::size_t replaceableStart = NOTHING_REPLACEABLE; //newest replaceable message in outbound
+		std::size_t replaceableSize = 0;
+		Clock::time_point lastProgress; //last time the socket took anything while data was queued
+		std::atomic<bool> wantsWrite = false; //watched for writability
+	};
+
+	void acceptPending();
+	void readDatagrams();
+	void readConnection(ConnectionID _connection);
+	void writeConnection(ConnectionID _connection); //sends queued bytes once the socket can take them
+	void closeConnection(ConnectionID _connection); //reactor thread only
+	void closePending();
+	void evictStalled(); //drops connections that have taken nothing for too long
+
+	std::shared_ptr<Connection> findConnection(ConnectionID _connection) const;
+	bool flushOutbound(Connection& _connection); //sendMutex held, false on a socket error
+	void scheduleClose(ConnectionID _id, Connection& _connection); //sendMutex held
+	void setWriteInterest(ConnectionID _id, Connection& _connection, bool _wanted);
+
+	void watch(SocketHandle _socket, std::uint64_t _key);
+	void unwatch(SocketHandle _socket);
+
+	SocketHandle listener = INVALID_SOCKET_HANDLE;
+	SocketHandle datagramSocket = INVALID_SOCKET_HANDLE;
+	static const std::uint64_t LISTENER_KEY = 0; //connection ids start at 1
+	static const std::uint64_t DATAGRAM_KEY = 1ull << 32; //above any connection id
+
+	std::unordered_map<ConnectionID, std::shared_ptr<Connection>> connections; //senders hold a reference while they write
+	mutable std::mutex connectionsMutex; //guards connections, never held while sending
+	std::vector<ConnectionID> pendingClose;
+	std::mutex closeMutex; //guards pendingClose, taken inside a sendMutex
+
+	SendLimits limits;
+	Clock::time_point nextStallCheck;
+	std::atomic<std::uint64_t> superseded = 0;
+	std::atomic<std::uint64_t> evicted = 0;
+
+	ConnectionID nextConnectionID = 1;
+	std::atomic<bool> running = false;
+
+	AcceptHandler onAccept;
+	MessageHandler onMessage;
+	CloseHandler onClose;
+	DatagramHandler onDatagram;
+
+#ifdef REACTOR_USE_EPOLL
+	int epollHandle = -1;
+#else
+	std::vector<pollfd> pollSet; //rebuilt each poll
+	std::vector<std::uint64_t> pollOwners; //watch key for each entry in pollSet
+#endif
+};
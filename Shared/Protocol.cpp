@@ -0,0 +1,36 @@
+#include "Protocol.h"
+
+std::size_t payloadSize(MessageType _type)
+{
+	switch (_type)
+	{
+	case MessageType::AssignID: return sizeof(AssignIDMessage);
+	case MessageType::PlayerInput: return sizeof(PlayerInputMessage);
+	case MessageType::UdpHello: return sizeof(UdpHelloMessage);
+	case MessageType::Snapshot: return sizeof(SnapshotMessage);
+	case MessageType::SnapshotAck: return sizeof(SnapshotAckMessage);
+	default: return 0;
+	}
+}
+
+bool hasVariableSize(MessageType _type)
+{
+	return _type == MessageType::Snapshot;
+}
+
+bool decodeHeader(const char* _data, MessageHeader& _header)
+{
+	std::memcpy(&_header, _data, sizeof(_header));
+
+	if (_header.version != PROTOCOL_VERSION)
+	{
+		return false;
+	}
+	MessageType type = static_cast<MessageType>(_header.type);
+	std::size_t expected = payloadSize(type);
+
+	if (expected != 0 && hasVariableSize(type)) {
+		return _header.length >= expected && _header.length <= MAX_SNAPSHOT_PAYLOAD;
+	}
+	return expected != 0 && expected == _header.length; //every other type has exactly one size
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/// wire protocol shared by the host and the clients
+/// every message is a fixed 8 byte header followed by a fixed size payload,
+/// payloads are plain structs so they are copied straight into and out of the socket buffers
+/// snapshots are the one exception, a fixed part followed by however many changes there were
+
+const std::uint8_t PROTOCOL_VERSION = 7;
+
+const std::size_t MAX_DATAGRAM_SIZE = 1200; //stays under a typical mtu so udp packets are never fragmented
+
+static_assert(std::endian::native == std::endian::little, "wire format is little endian");
+
+enum class MessageType : std::uint8_t
+{
+	AssignID = 1, //host -> client, id given to the joining player
+	PlayerInput, //client -> host, movement direction
+	UdpHello, //client -> host over udp to link it to the tcp session, echoed back once linked
+	Snapshot, //host -> client, world state as changes against a snapshot the client acknowledged
+	SnapshotAck, //client -> host, newest snapshot the client has applied
+	Count
+};
+
+#pragma pack(push, 1)
+struct MessageHeader
+{
+	std::uint8_t version;
+	std::uint8_t type;
+	std::uint16_t length; //payload bytes following the header
+	std::uint32_t sequence; //senders running message count
+};
+
+struct AssignIDMessage
+{
+	static constexpr MessageType TYPE = MessageType::AssignID;
+	std::int32_t playerID;
+	std::uint32_t udpToken; //proves a udp sender owns this tcp session
+	std::uint16_t tickRate; //lets the client turn snapshot ticks into host time
+};
+
+struct PlayerInputMessage
+{
+	static constexpr MessageType TYPE = MessageType::PlayerInput;
+	std::uint32_t inputSequence; //counts inputs only, echoed back in snapshots once applied
+	std::uint32_t viewTick; //host tick remote players were drawn at when this was sent, 0 if not known yet
+	std::int8_t xDir;
+	std::int8_t yDir;
+};
+
+struct UdpHelloMessage
+{
+	static constexpr MessageType TYPE = MessageType::UdpHello;
+	std::uint32_t udpToken;
+};
+
+/// fixed part of a snapshot, the changes follow it bit packed (see Snapshot.cpp)
+struct SnapshotMessage
+{
+	static constexpr MessageType TYPE = MessageType::Snapshot;
+	std::uint32_t tick;
+	std::uint32_t baselineTick; //snapshot the changes are against, 0 for the empty world
+	std::uint32_t lastInput; //newest input from this client the snapshot includes
+};
+
+struct SnapshotAckMessage
+{
+	static constexpr MessageType TYPE = MessageType::SnapshotAck;
+	std::uint32_t udpToken; //identifies the sender when the ack comes over udp
+	std::uint32_t tick;
+};
+#pragma pack(pop)
+
+/// a snapshot always fits in a single datagram
+constexpr std::size_t MAX_SNAPSHOT_PAYLOAD = MAX_DATAGRAM_SIZE - sizeof(MessageHeader);
+
+/// <summary>
+/// full size of a message on the wire, header included
+/// </summary>
+template<typename T>
+constexpr std::size_t messageSize()
+{
+	return sizeof(MessageHeader) + sizeof(T);
+}
+
+/// largest message any side can send, used to size stack buffers
+constexpr std::size_t MAX_MESSAGE_SIZE = (std::max)({
+	messageSize<AssignIDMessage>(),
+	messageSize<PlayerInputMessage>(),
+	messageSize<UdpHelloMessage>(),
+	sizeof(MessageHeader) + MAX_SNAPSHOT_PAYLOAD,
+	messageSize<SnapshotAckMessage>() });
+
+/// <summary>
+/// payload size expected for a message type, only the fixed part for snapshots
+/// </summary>
+/// <returns>size in bytes, 0 if the type is unknown</returns>
+std::size_t payloadSize(MessageType _type);
+
+/// <summary>
+/// true for types whose payload carries extra data after the fixed part
+/// </summary>
+bool hasVariableSize(MessageType _type);
+
+/// <summary>
+/// writes a message header, for callers that build the payload themselves
+/// </summary>
+inline void encodeHeader(MessageType _type, std::size_t _length, std::uint32_t _sequence, char* _out)
+{
+	MessageHeader header{ PROTOCOL_VERSION, static_cast<std::uint8_t>(_type), static_cast<std::uint16_t>(_length), _sequence };
+	std::memcpy(_out, &header, sizeof(header));
+}
+
+/// <summary>
+/// reads a header and checks the version, type and length all agree
+/// </summary>
+/// <param name="_data">at least sizeof(MessageHeader) bytes</param>
+/// <returns>false if the header is not one we understand</returns>
+bool decodeHeader(const char* _data, MessageHeader& _header);
+
+/// <summary>
+/// writes header and payload into _out, no allocation
+/// </summary>
+/// <param name="_out">must hold messageSize<T>() bytes</param>
+/// <returns>bytes written</returns>
+template<typename T>
+std::size_t encodeMessage(const T& _payload, std::uint32_t _sequence, char* _out)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "payloads must be trivially copyable");
+
+	encodeHeader(T::TYPE, sizeof(T), _sequence, _out);
+	std::memcpy(_out + sizeof(MessageHeader), &_payload, sizeof(T));
+	return messageSize<T>();
+}
+
+/// <summary>
+/// copies a payload out of the buffer, header must already be validated
+/// </summary>
+/// <param name="_payload">first byte after the header</param>
+template<typename T>
+T decodePayload(const char* _payload)
+{
+	static_assert(std::is_trivially_copyable_v<T>, "payloads must be trivially copyable");
+
+	T payload;
+	std::memcpy(&payload, _payload, sizeof(T));
+	return payload;
+}
+
+/// <summary>
+/// walks every message packed back to back in a datagram
+/// </summary>
+/// <param name="_handler">called with each header and payload</param>
+/// <returns>false if anything in the datagram failed to decode</returns>
+template<typename Handler>
+bool forEachMessage(const char* _data, std::size_t _size, Handler&& _handler)
+{
+	std::size_t offset = 0;
+	MessageHeader header;
+	while (_size - offset >= sizeof(MessageHeader)) {
+		if (!decodeHeader(_data + offset, header) || _size - offset < sizeof(MessageHeader) + header.length) {
+			return false;
+		}
+		_handler(header, _data + offset + sizeof(MessageHeader));
+		offset += sizeof(MessageHeader) + header.length;
+	}
+	return offset == _size;
+}
+
+/// <summary>
+/// true if _sequence came after _last, allowing for wrap around
+/// </summary>
+inline bool isNewerSequence(std::uint32_t _sequence, std::uint32_t _last)
+{
+	return static_cast<std::int32_t>(_sequence - _last) > 0;
+}
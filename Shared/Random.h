@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// xoshiro128** by Blackman and Vigna, four words of state and a handful of shifts per number
+/// each match owns one seeded from its config, so the same seed and inputs replay the same match anywhere
+/// unlike rand() nothing else in the process can move it on
+/// </summary>
+class Xoshiro128
+{
+public:
+	using State = std::array<std::uint32_t, 4>;
+
+	explicit Xoshiro128(std::uint64_t _seed = 1) { seed(_seed); }
+
+	/// <summary>
+	/// spreads the seed over the state with splitmix64, so nearby seeds still give unrelated matches
+	/// </summary>
+	void seed(std::uint64_t _seed)
+	{
+		for (std::size_t i = 0; i < state.size(); i += 2) {
+			_seed += 0x9E3779B97F4A7C15ull;
+			std::uint64_t mixed = _seed;
+			mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+			mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+			mixed ^= mixed >> 31;
+			state[i] = static_cast<std::uint32_t>(mixed);
+			state[i + 1] = static_cast<std::uint32_t>(mixed >> 32);
+		}
+		if ((state[0] | state[1] | state[2] | state[3]) == 0) {
+			state[0] = 1; //all zero never leaves zero
+		}
+	}
+
+	std::uint32_t next()
+	{
+		std::uint32_t result = rotate(state[1] * 5, 7) * 9;
+		std::uint32_t shifted = state[1] << 9;
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= shifted;
+		state[3] = rotate(state[3], 11);
+		return result;
+	}
+
+	/// <summary>
+	/// evenly spread over 0 to _bound - 1 using the top bits of a 64 bit product, no modulo bias
+	/// </summary>
+	std::uint32_t below(std::uint32_t _bound)
+	{
+		if (_bound == 0) {
+			return 0;
+		}
+		std::uint64_t product = static_cast<std::uint64_t>(next()) * _bound;
+		std::uint32_t low = static_cast<std::uint32_t>(product);
+		if (low < _bound) {
+			std::uint32_t threshold = (0u - _bound) % _bound;
+			while (low < threshold) {
+				product = static_cast<std::uint64_t>(next()) * _bound;
+				low = static_cast<std::uint32_t>(product);
+			}
+		}
+		return static_cast<std::uint32_t>(product >> 32);
+	}
+
+	const State& getState() const { return state; } //for keyframes
+	void setState(const State& _state) { state = _state; }
+
+private:
+	static std::uint32_t rotate(std::uint32_t _value, int _bits) { return (_value << _bits) | (_value >> (32 - _bits)); }
+
+	State state{};
+};
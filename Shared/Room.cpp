@@ -0,0 +1,419 @@
+#include "Room.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+/// a room can hold no more players than one snapshot datagram can describe,
+/// and rooms given a seed each play a different match from it
+static SimulationConfig roomSimulation(SimulationConfig _config, int _room)
+{
+	_config.maxPlayers = std::min(_config.maxPlayers, static_cast<int>(MAX_SNAPSHOT_PLAYERS));
+	_config.seed = _config.seed == 0 ? 0 : _config.seed + static_cast<std::uint64_t>(_room);
+	return _config;
+}
+
+Room::Room(int _id, const ServerConfig& _config, NetworkReactor& _reactor) :
+	id(_id),
+	config(_config),
+	reactor(_reactor),
+	simulation(roomSimulation(_config.simulation, _id))
+{
+	simulation.setProfiler(&profiler);
+
+	if (!config.recordDirectory.empty()) {
+		std::string path = config.recordDirectory + "/room" + std::to_string(id) + "-" + std::to_string(std::time(nullptr)) + ".tagrec";
+		if (recorder.open(path, simulation.getConfig())) {
+			std::cout << "Recording room " << id << " to " << path << "\n";
+		}
+	}
+}
+
+/// <summary>
+/// gives a new client an id and a player if there is room
+/// </summary>
+/// <returns>false if the match is full</returns>
+bool Room::addClient(ConnectionID _connection, std::uint32_t _udpToken)
+{
+	int playerID = simulation.addPlayer();
+	if (playerID == -1) {
+		return false;
+	}
+
+	recorder.playerJoined(playerID);
+	std::cout << "Client connected to room " << id << "\n"; //client joined
+	ClientSession& session = clients[_connection];
+	session.playerID = playerID;
+	session.udpToken = _udpToken;
+
+	AssignIDMessage assign;
+	assign.playerID = playerID;
+	assign.udpToken = _udpToken;
+	assign.tickRate = static_cast<std::uint16_t>(config.simulation.tickRate);
+	sendMessage(_connection, assign); //send new players id to client so he can set his
+	//no baseline acked yet, so the next snapshot carries the whole world
+	return true;
+}
+
+/// <summary>
+/// removes a gone client, everyone else sees them missing from the next snapshot
+/// </summary>
+void Room::removeClient(ConnectionID _connection)
+{
+	auto it = clients.find(_connection);
+	if (it == clients.end()) {
+		return;
+	}
+
+	int removedID = it->second.playerID;
+	std::cout << "Removing player ID: " << removedID << " from room " << id << "\n";
+
+	clients.erase(it);
+	recorder.playerLeft(removedID);
+	simulation.removePlayer(removedID);
+}
+
+void Room::queueEvent(const NetworkEvent& _event)
+{
+	pendingEvents.push_back(_event);
+}
+
+int Room::addLocalPlayer()
+{
+	int playerID = simulation.addPlayer();
+	if (playerID != -1) {
+		recorder.playerJoined(playerID);
+	}
+	return playerID;
+}
+
+void Room::submitLocalInput(int _playerID, int _xDir, int _yDir)
+{
+	recorder.input(_playerID, _xDir, _yDir, 0);
+	simulation.queueInput(_playerID, _xDir, _yDir);
+}
+
+/// <summary>
+/// applies everything routed here, steps the match once and sends out what changed
+/// </summary>
+void Room::tick()
+{
+	profiler.start();
+	processEvents(); //inputs and acks since last tick
+	profiler.lap(TickPhase::Input);
+	simulation.step(); //laps its own phases
+	recorder.stepped(simulation);
+	sendSnapshots();
+	flushOutboxes(); //one send per client per tick
+	profiler.lap(TickPhase::Broadcast);
+	profiler.finish();
+}
+
+void Room::processEvents()
+{
+	lastEventCount = pendingEvents.size();
+	for (const NetworkEvent& event : pendingEvents) {
+		switch (event.type)
+		{
+		case NetworkEventType::Input:
+			countIncoming(event.connection, messageSize<PlayerInputMessage>());
+			handleClientInput(event.connection, event.input);
+			break;
+		case NetworkEventType::DatagramHello:
+			countIncoming(event.connection, messageSize<UdpHelloMessage>());
+			handleDatagramHello(event.connection, event.udpToken, event.address);
+			break;
+		case NetworkEventType::SnapshotAcked: {
+			countIncoming(event.connection, messageSize<SnapshotAckMessage>());
+			auto it = clients.find(event.connection);
+			if (it != clients.end()) {
+				handleSnapshotAck(it->second, event);
+			}
+			break;
+		}
+		case NetworkEventType::DatagramSnapshotAcked:
+			countIncoming(event.connection, messageSize<SnapshotAckMessage>());
+			if (ClientSession* session = findDatagramSession(event.connection, event.udpToken, event.address)) {
+				handleSnapshotAck(*session, event);
+			}
+			break;
+		default:
+			break; //joins and leaves are handled by the server as they arrive
+		}
+	}
+	pendingEvents.clear();
+}
+
+void Room::handleClientInput(ConnectionID _connection, const PlayerInputMessage& _input)
+{
+	auto it = clients.find(_connection);
+	if (it == clients.end()) {
+		return; //only update if there is an active player for the client
+	}
+	ClientSession& session = it->second;
+	if (!isNewerSequence(_input.inputSequence, session.lastInput)) {
+		return; //already applied, each input moves the player exactly once
+	}
+	session.lastInput = _input.inputSequence;
+	recorder.input(session.playerID, _input.xDir, _input.yDir, _input.viewTick);
+	simulation.queueInput(session.playerID, _input.xDir, _input.yDir, _input.viewTick, _input.inputSequence);
+}
+
+/// <summary>
+/// links the sender of a hello to the session that owns the token and echoes it so the client stops asking
+/// </summary>
+void Room::handleDatagramHello(ConnectionID _connection, std::uint32_t _token, const SocketAddress& _address)
+{
+	auto it = clients.find(_connection);
+	if (it == clients.end() || it->second.udpToken != _token) {
+		return; //left since the hello was routed
+	}
+	ClientSession& session = it->second;
+	if (!session.udpBound) {
+		std::cout << "Udp linked for player ID: " << session.playerID << "\n";
+	}
+	session.udpBound = true;
+	session.udpAddress = _address; //follows the client if its port changes
+
+	char buffer[messageSize<UdpHelloMessage>()];
+	encodeMessage(UdpHelloMessage{ _token }, outgoingSequence++, buffer);
+	session.datagramOutbox.insert(session.datagramOutbox.end(), buffer, buffer + sizeof(buffer));
+	session.traffic.bytesOut += sizeof(buffer);
+	++session.traffic.messagesOut;
+}
+
+/// <summary>
+/// moves a clients baseline forward, acks can arrive late or out of order so older ones are ignored
+/// the first ack for a snapshot times the round trip, smoothed the way tcp smooths its own
+/// </summary>
+void Room::handleSnapshotAck(ClientSession& _session, const NetworkEvent& _event)
+{
+	std::uint32_t tick = _event.tick;
+	if (!isNewerSequence(tick, _session.ackedTick) || isNewerSequence(tick, static_cast<std::uint32_t>(simulation.getTick()))) {
+		return;
+	}
+	_session.ackedTick = tick;
+
+	const SentSnapshot& sent = sentSnapshots[tick % SNAPSHOT_HISTORY];
+	if (sent.tick != tick || _event.received < sent.at) {
+		return; //already overwritten
+	}
+	double roundTripMs = std::chrono::duration<double, std::milli>(_event.received - sent.at).count();
+	roundTrips.record(roundTripMs / 1000.0);
+	_session.roundTripMs = _session.roundTripMs == 0.0 ? roundTripMs : _session.roundTripMs + (roundTripMs - _session.roundTripMs) / 8.0;
+}
+
+void Room::countIncoming(ConnectionID _connection, std::size_t _size)
+{
+	auto it = clients.find(_connection);
+	if (it != clients.end()) {
+		it->second.traffic.bytesIn += _size;
+		++it->second.traffic.messagesIn;
+	}
+}
+
+ClientSession* Room::findDatagramSession(ConnectionID _connection, std::uint32_t _token, const SocketAddress& _address)
+{
+	auto it = clients.find(_connection);
+	if (it == clients.end() || it->second.udpToken != _token) {
+		return nullptr;
+	}
+	ClientSession& session = it->second;
+	if (!session.udpBound || !sameAddress(session.udpAddress, _address)) {
+		return nullptr; //token is not enough, it has to come from the linked address
+	}
+	return &session;
+}
+
+/// <summary>
+/// copies what the clients draw out of the simulation, sorted by slot so deltas can walk two snapshots together
+/// </summary>
+void Room::captureSnapshot(Snapshot& _snapshot) const
+{
+	_snapshot.players.clear();
+	for (const PlayerState& player : simulation.getPlayers()) {
+		SnapshotPlayer entry;
+		entry.id = player.id;
+		entry.x = static_cast<std::uint16_t>(POSITION_X.quantize(player.x.toFloat()));
+		entry.y = static_cast<std::uint16_t>(POSITION_Y.quantize(player.y.toFloat()));
+		entry.isIt = player.isIt;
+		entry.invisible = player.invisible;
+		_snapshot.players.push_back(entry);
+	}
+	std::sort(_snapshot.players.begin(), _snapshot.players.end(),
+		[](const SnapshotPlayer& _first, const SnapshotPlayer& _second) { return SlotID::index(_first.id) < SlotID::index(_second.id); });
+
+	const PickUpState& pickUp = simulation.getPickUp();
+	_snapshot.pickUpActive = pickUp.active;
+	_snapshot.pickUpX = pickUp.active ? static_cast<std::uint16_t>(POSITION_X.quantize(pickUp.x.toFloat())) : 0;
+	_snapshot.pickUpY = pickUp.active ? static_cast<std::uint16_t>(POSITION_Y.quantize(pickUp.y.toFloat())) : 0;
+
+	_snapshot.gameOver = simulation.getState() == MatchState::GameOver;
+	_snapshot.survivalMillis = _snapshot.gameOver ? static_cast<std::uint32_t>(simulation.getSurvivalTime() * 1000.f) : 0;
+}
+
+/// <summary>
+/// captures this tick and sends each client only what changed since the snapshot it last acknowledged
+/// clients whose baseline has fallen out of the history get the whole world again
+/// </summary>
+void Room::sendSnapshots()
+{
+	if (clients.empty() || simulation.getTick() % config.snapshotInterval != 0) {
+		return;
+	}
+	Snapshot& current = snapshots.store(static_cast<std::uint32_t>(simulation.getTick()));
+	captureSnapshot(current);
+	sentSnapshots[current.tick % SNAPSHOT_HISTORY] = SentSnapshot{ current.tick, std::chrono::steady_clock::now() };
+
+	encodedCount = 0;
+	for (auto& [connection, session] : clients)
+	{
+		const Snapshot* baseline = snapshots.find(session.ackedTick);
+		if (baseline == nullptr) {
+			session.ackedTick = 0; //too old to delta against
+			baseline = snapshots.find(0);
+		}
+
+		SharedBuffer changes = encodeChanges(*baseline, current);
+		if (!changes) {
+			std::cerr << "Too many players for a snapshot to connection " << connection << "\n";
+			continue; //the others may be on a baseline that still fits
+		}
+		const PlayerState* player = simulation.findPlayer(session.playerID);
+		std::uint32_t appliedInput = player != nullptr ? player->appliedInput : session.sentLastInput;
+		bool inputsApplied = appliedInput != session.sentLastInput; //client is waiting to hear these were applied
+		bool empty = isEmptySnapshotChanges(changes->size()) && !inputsApplied;
+		if (empty && session.idle && current.tick - session.ackedTick < SNAPSHOT_HISTORY / 2) {
+			continue; //client is up to date and its baseline is not about to expire
+		}
+		session.idle = empty; //one empty snapshot still goes out so interpolation sees things stop
+		encodeSnapshotPrefix(baseline->tick, current.tick, appliedInput, outgoingSequence++, changes->size(), session.snapshotPrefix);
+		session.sentLastInput = appliedInput;
+		session.traffic.bytesOut += sizeof(session.snapshotPrefix) + changes->size();
+		++session.traffic.messagesOut;
+		session.snapshotChanges = std::move(changes);
+	}
+}
+
+/// <summary>
+/// clients mostly ack the same few ticks, so the changes are encoded once for each baseline in use
+/// rather than once for each client
+/// </summary>
+SharedBuffer Room::encodeChanges(const Snapshot& _baseline, const Snapshot& _current)
+{
+	for (std::size_t i = 0; i < encodedCount; ++i) {
+		if (encodedChanges[i].baselineTick == _baseline.tick) {
+			return encodedChanges[i].bytes;
+		}
+	}
+
+	if (encodedCount == encodedChanges.size()) {
+		encodedChanges.emplace_back();
+	}
+	EncodedChanges& entry = encodedChanges[encodedCount];
+	if (!entry.bytes || entry.bytes.use_count() > 1) {
+		entry.bytes = std::make_shared<std::vector<char>>(); //still held somewhere, leave it be
+	}
+	entry.bytes->resize(MAX_SNAPSHOT_CHANGES);
+	std::size_t size = encodeSnapshotChanges(_baseline, _current, entry.bytes->data());
+	if (size == 0) {
+		return nullptr;
+	}
+	entry.bytes->resize(size);
+	entry.baselineTick = _baseline.tick;
+	++encodedCount;
+	return entry.bytes;
+}
+
+/// <summary>
+/// hands each client its tick in one gathered write, the snapshot as a separate replaceable message
+/// so a newer one can take its place while it is still queued, then sends every datagram in one batch
+/// </summary>
+void Room::flushOutboxes()
+{
+	datagramPieces.clear();
+	datagrams.clear();
+	for (auto& [connection, session] : clients)
+	{
+		ConstBuffer pieces[3];
+		std::size_t count = 0;
+		if (!session.outbox.empty()) {
+			pieces[count++] = ConstBuffer{ session.outbox.data(), session.outbox.size() };
+		}
+		std::size_t replaceableFrom = count;
+		if (session.snapshotChanges && !session.udpBound) {
+			//deltas are against acked baselines, so an unsent snapshot is no use once a newer one exists
+			pieces[count++] = ConstBuffer{ session.snapshotPrefix, sizeof(session.snapshotPrefix) };
+			pieces[count++] = ConstBuffer{ session.snapshotChanges->data(), session.snapshotChanges->size() };
+		}
+		if (count > 0) {
+			reactor.send(connection, pieces, count, replaceableFrom);
+		}
+		if (session.udpBound) {
+			gatherDatagrams(session);
+		}
+	}
+
+	const ConstBuffer* next = datagramPieces.data(); //stable now nothing more is added
+	for (OutgoingDatagram& datagram : datagrams) {
+		datagram.buffers = next;
+		next += datagram.count;
+	}
+	if (!datagrams.empty()) {
+		reactor.sendDatagrams(datagrams.data(), datagrams.size());
+	}
+
+	for (auto& [connection, session] : clients) {
+		session.outbox.clear();
+		session.datagramOutbox.clear();
+		session.snapshotChanges.reset(); //lets the encoded changes be reused next tick
+	}
+}
+
+/// <summary>
+/// splits the datagram outbox into as few datagrams as fit the mtu, never splitting a message,
+/// with the snapshot behind the last of them if it fits
+/// </summary>
+void Room::gatherDatagrams(ClientSession& _session)
+{
+	const char* data = _session.datagramOutbox.data();
+	std::size_t size = _session.datagramOutbox.size();
+	std::size_t start = 0;
+	std::size_t end = 0;
+
+	auto addDatagram = [this, &_session](std::size_t _firstPiece) {
+		datagrams.push_back(OutgoingDatagram{ _session.udpAddress, nullptr, datagramPieces.size() - _firstPiece }); //pieces pointed at once all are in
+	};
+
+	while (end < size) {
+		MessageHeader header;
+		std::memcpy(&header, data + end, sizeof(header)); //we encoded these, no need to validate
+		std::size_t frame = sizeof(MessageHeader) + header.length;
+
+		if (end + frame - start > MAX_DATAGRAM_SIZE && end > start) {
+			datagramPieces.push_back(ConstBuffer{ data + start, end - start });
+			addDatagram(datagramPieces.size() - 1);
+			start = end;
+		}
+		end += frame;
+	}
+
+	std::size_t snapshotSize = _session.snapshotChanges ? sizeof(_session.snapshotPrefix) + _session.snapshotChanges->size() : 0;
+	if (end > start && end - start + snapshotSize > MAX_DATAGRAM_SIZE) {
+		datagramPieces.push_back(ConstBuffer{ data + start, end - start });
+		addDatagram(datagramPieces.size() - 1);
+		start = end;
+	}
+
+	std::size_t firstPiece = datagramPieces.size();
+	if (end > start) {
+		datagramPieces.push_back(ConstBuffer{ data + start, end - start });
+	}
+	if (_session.snapshotChanges) {
+		datagramPieces.push_back(ConstBuffer{ _session.snapshotPrefix, sizeof(_session.snapshotPrefix) });
+		datagramPieces.push_back(ConstBuffer{ _session.snapshotChanges->data(), _session.snapshotChanges->size() });
+	}
+	if (datagramPieces.size() > firstPiece) {
+		addDatagram(firstPiece);
+	}
+}
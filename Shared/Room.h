@@ -0,0 +1,191 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MatchRecording.h"
+#include "NetworkReactor.h"
+#include "Simulation.h"
+#include "Snapshot.h"
+#include "TickProfiler.h"
+
+using SharedBuffer = std::shared_ptr<const std::vector<char>>; //encoded once and read by every clients gathered write, whatever a connection cannot send at once is copied into its own backlog
+
+enum class NetworkEventType
+{
+	Connected,
+	Input,
+	Disconnected,
+	DatagramHello, //udp hello, links an address to a session
+	SnapshotAcked, //client has applied a snapshot, over tcp
+	DatagramSnapshotAcked //same over udp, matched to a session by token and address
+};
+
+/// handed from the network thread to the simulation thread
+struct NetworkEvent
+{
+	NetworkEventType type;
+	ConnectionID connection;
+	PlayerInputMessage input; //only set for Input
+	std::uint32_t udpToken = 0; //only set for datagram events
+	SocketAddress address{}; //only set for datagram events
+	std::uint32_t tick = 0; //only set for acks
+	std::chrono::steady_clock::time_point received{}; //only set for acks, so the round trip leaves out the wait for the tick
+};
+
+/// what one client has sent and been sent, counted as whole messages
+struct ClientTraffic
+{
+	std::uint64_t bytesIn = 0;
+	std::uint64_t bytesOut = 0; //handed to the reactor, a superseded snapshot still counts
+	std::uint64_t messagesIn = 0;
+	std::uint64_t messagesOut = 0;
+};
+
+/// <summary>
+/// a connected client, everything sent to it during a tick is gathered in the outbox
+/// and written in one go when the tick ends, snapshots are deltas against ackedTick
+/// and go out behind the outbox as their own prefix and the changes shared with other clients
+/// </summary>
+struct ClientSession
+{
+	int playerID = -1;
+	std::vector<char> outbox; //capacity is kept between ticks so steady state never allocates
+
+	char snapshotPrefix[SNAPSHOT_PREFIX_SIZE]; //this ticks snapshot header, the sequence and applied input are per client
+	SharedBuffer snapshotChanges; //the rest of it, shared by every client on the same baseline, empty if none goes this tick
+
+	std::uint32_t udpToken = 0; //handed out over tcp, sent back over udp to link the two
+	bool udpBound = false; //positions go over udp once linked, over tcp until then
+	SocketAddress udpAddress{};
+	std::vector<char> datagramOutbox; //unreliable messages for this tick
+
+	std::uint32_t ackedTick = 0; //newest snapshot the client has, 0 until it acks one
+
+	std::uint32_t lastInput = 0; //newest input queued for the simulation, repeats are dropped
+	std::uint32_t sentLastInput = 0; //newest input the simulation had applied as of the last snapshot sent
+	bool idle = false; //last snapshot sent had no changes, more of those can be skipped
+
+	ClientTraffic traffic;
+	double roundTripMs = 0.0; //smoothed from snapshot send to its ack, 0 until the first ack
+};
+
+struct ServerConfig
+{
+	unsigned short port = 53000;
+	int snapshotInterval = 1; //ticks between snapshots, clients interpolate across the gap
+	int maxRooms = 1; //matches run side by side, the windowed host only draws the first
+	int workerThreads = 0; //threads ticking rooms, 0 uses every core
+	unsigned short metricsPort = 0; //prometheus page on loopback, 0 for none
+	std::string recordDirectory; //every room records its match here for replaying, empty for none
+	SendLimits sendLimits; //how far behind a client may fall before it is dropped
+	SimulationConfig simulation;
+};
+
+/// <summary>
+/// one match and the clients playing in it, rooms share nothing but the reactor
+/// so the server can tick any number of them at once on different threads
+/// </summary>
+class Room
+{
+public:
+	Room(int _id, const ServerConfig& _config, NetworkReactor& _reactor);
+
+	//between ticks only, the server calls these while no room is ticking
+	bool addClient(ConnectionID _connection, std::uint32_t _udpToken); //false if the room is full
+	void removeClient(ConnectionID _connection);
+	void queueEvent(const NetworkEvent& _event); //input, acks and hellos for the next tick
+	int addLocalPlayer(); //a player without a connection, used for the hosts own player
+	void submitLocalInput(int _playerID, int _xDir, int _yDir);
+
+	void tick(); //applies queued events, steps the match and sends out what changed
+
+	int getID() const { return id; }
+	bool isFull() const { return static_cast<int>(simulation.getPlayers().size()) >= simulation.getMaxPlayers(); }
+	const Simulation& getSimulation() const { return simulation; }
+	std::size_t getClientCount() const { return clients.size(); }
+
+	//between ticks only, for reporting
+	const std::unordered_map<ConnectionID, ClientSession>& getClients() const { return clients; }
+	const TickProfiler& getProfiler() const { return profiler; }
+	const DurationHistogram& getRoundTrips() const { return roundTrips; }
+	std::size_t getLastEventCount() const { return lastEventCount; } //events drained by the last tick
+
+private:
+	void processEvents();
+
+	void handleClientInput(ConnectionID _connection, const PlayerInputMessage& _input); //queues a clients movement
+	void handleDatagramHello(ConnectionID _connection, std::uint32_t _token, const SocketAddress& _address); //links a udp address to its session
+	void handleSnapshotAck(ClientSession& _session, const NetworkEvent& _event);
+	void countIncoming(ConnectionID _connection, std::size_t _size); //one message from a client
+	ClientSession* findDatagramSession(ConnectionID _connection, std::uint32_t _token, const SocketAddress& _address); //nullptr unless linked from that address
+
+	void captureSnapshot(Snapshot& _snapshot) const; //world as the clients see it
+	void sendSnapshots(); //one delta per client against what it last acknowledged
+	SharedBuffer encodeChanges(const Snapshot& _baseline, const Snapshot& _current); //encoded once per baseline per tick, nullptr if too many players
+	void flushOutboxes(); //one write per client with everything queued this tick
+	void gatherDatagrams(ClientSession& _session); //mtu sized datagrams, split between messages
+
+	template<typename T>
+	void sendMessage(ConnectionID _connection, const T& _payload); //queues for a single client
+
+	int id;
+	const ServerConfig& config;
+	NetworkReactor& reactor;
+	Simulation simulation;
+
+	std::vector<NetworkEvent> pendingEvents; //routed here by the server, drained each tick
+	std::size_t lastEventCount = 0;
+	std::unordered_map<ConnectionID, ClientSession> clients; //connected clients and their players
+
+	SnapshotHistory snapshots; //baselines the clients may have acknowledged
+
+	/// changes from one baseline to this ticks snapshot, the buffers are reused once every session lets go
+	struct EncodedChanges
+	{
+		std::uint32_t baselineTick = 0;
+		std::shared_ptr<std::vector<char>> bytes;
+	};
+	std::vector<EncodedChanges> encodedChanges;
+	std::size_t encodedCount = 0; //entries in use this tick
+
+	std::vector<ConstBuffer> datagramPieces; //every clients datagrams for a tick, sent in one batch
+	std::vector<OutgoingDatagram> datagrams;
+
+	std::uint32_t outgoingSequence = 0; //sequence stamped on every sent message
+
+	MatchRecorder recorder; //closed unless the server records matches
+
+	TickProfiler profiler; //only this rooms ticking thread touches it
+	DurationHistogram roundTrips;
+
+	/// when a tick's snapshot went out, an ack for it gives the round trip
+	struct SentSnapshot
+	{
+		std::uint32_t tick = 0;
+		std::chrono::steady_clock::time_point at{};
+	};
+	std::array<SentSnapshot, SNAPSHOT_HISTORY> sentSnapshots{}; //indexed by tick, older acks are not worth timing
+};
+
+/// <summary>
+/// encodes a message and appends it to one clients outbox
+/// </summary>
+template<typename T>
+void Room::sendMessage(ConnectionID _connection, const T& _payload)
+{
+	auto it = clients.find(_connection);
+	if (it == clients.end()) {
+		return;
+	}
+
+	char buffer[messageSize<T>()];
+	encodeMessage(_payload, outgoingSequence++, buffer);
+
+	it->second.outbox.insert(it->second.outbox.end(), buffer, buffer + sizeof(buffer));
+	it->second.traffic.bytesOut += sizeof(buffer);
+	++it->second.traffic.messagesOut;
+}
@@ -0,0 +1,336 @@
+#include "Server.h"
+#include <algorithm>
+#include <iostream>
+
+Server::Server(const ServerConfig& _config) :
+	config(_config),
+	pool(static_cast<std::size_t>(std::max(_config.workerThreads, 0)))
+{
+	config.maxRooms = std::max(config.maxRooms, 1);
+	rooms.push_back(std::make_unique<Room>(0, config, reactor)); //always open, the host plays here
+}
+
+Server::~Server()
+{
+	stop();
+}
+
+/// <summary>
+/// opens the listener and hands the reactor its own thread
+/// </summary>
+/// <returns>false if the port could not be bound</returns>
+bool Server::start()
+{
+	reactor.setSendLimits(config.sendLimits);
+	if (!reactor.listen(config.port)) {
+		return false;
+	}
+	bool datagramOpen = reactor.openDatagram(config.port, //udp on the same port number
+		[this](const SocketAddress& _from, const MessageHeader& _header, const char* _payload) {
+			NetworkEvent event{ NetworkEventType::DatagramHello, 0, {} };
+			event.address = _from;
+			switch (static_cast<MessageType>(_header.type))
+			{
+			case MessageType::UdpHello:
+				event.udpToken = decodePayload<UdpHelloMessage>(_payload).udpToken;
+				queueNetworkEvent(event);
+				break;
+			case MessageType::SnapshotAck: {
+				SnapshotAckMessage ack = decodePayload<SnapshotAckMessage>(_payload);
+				event.type = NetworkEventType::DatagramSnapshotAcked;
+				event.udpToken = ack.udpToken;
+				event.tick = ack.tick;
+				event.received = Clock::now();
+				queueNetworkEvent(event);
+				break;
+			}
+			default:
+				break; //nothing else is expected over udp
+			}
+		});
+	if (!datagramOpen) {
+		std::cerr << "Udp unavailable, positions will go over tcp" << "\n";
+	}
+
+	std::cout << "Server listening on port " << config.port << "\n";  // successful bind and listen
+
+	//the reactor only decodes, everything it finds is queued for the simulation thread
+	reactor.setHandlers(
+		[this](ConnectionID _connection) {
+			queueNetworkEvent({ NetworkEventType::Connected, _connection, {} });
+		},
+		[this](ConnectionID _connection, const MessageHeader& _header, const char* _payload) {
+			switch (static_cast<MessageType>(_header.type))
+			{
+			case MessageType::PlayerInput:
+				queueNetworkEvent({ NetworkEventType::Input, _connection, decodePayload<PlayerInputMessage>(_payload) });
+				break;
+			case MessageType::SnapshotAck: {
+				NetworkEvent event{ NetworkEventType::SnapshotAcked, _connection, {} };
+				event.tick = decodePayload<SnapshotAckMessage>(_payload).tick;
+				event.received = Clock::now();
+				queueNetworkEvent(event);
+				break;
+			}
+			default:
+				break; //clients only send input and acks
+			}
+		},
+		[this](ConnectionID _connection) {
+			queueNetworkEvent({ NetworkEventType::Disconnected, _connection, {} });
+		});
+
+	networkThread = std::thread(&NetworkReactor::run, &reactor); //one thread for every socket
+
+	if (config.metricsPort != 0 && !metrics.start(config.metricsPort)) {
+		std::cerr << "Metrics unavailable, playing on without them" << "\n";
+	}
+	return true;
+}
+
+void Server::stop()
+{
+	metrics.stop();
+	stopping = true;
+	reactor.stop();
+	if (networkThread.joinable()) {
+		networkThread.join();
+	}
+}
+
+/// <summary>
+/// routes everything that arrived and ticks every room once, rooms share nothing so they run side by side
+/// </summary>
+void Server::tick()
+{
+	Clock::time_point start = Clock::now();
+	processNetworkEvents(); //joins, inputs and leaves since last tick
+	pool.parallelFor(rooms.size(), [this](std::size_t _room) {
+		rooms[_room]->tick();
+	});
+
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	tickDurations.record(seconds);
+	if (seconds * config.simulation.tickRate > 1.0) {
+		++overrunTicks;
+	}
+	if (metrics.isRunning() && start >= nextMetrics) {
+		publishMetrics(); //after the tick was timed, the page is not part of its cost
+		nextMetrics = start + METRICS_INTERVAL;
+	}
+}
+
+int Server::addLocalPlayer()
+{
+	return rooms.front()->addLocalPlayer();
+}
+
+void Server::submitLocalInput(int _playerID, int _xDir, int _yDir)
+{
+	rooms.front()->submitLocalInput(_playerID, _xDir, _yDir);
+}
+
+/// <summary>
+/// queues an event from the network thread for the next tick
+/// </summary>
+void Server::queueNetworkEvent(const NetworkEvent& _event)
+{
+	if (networkEvents.tryPush(_event)) {
+		return;
+	}
+	if (_event.type == NetworkEventType::Connected || _event.type == NetworkEventType::Disconnected) {
+		while (!networkEvents.tryPush(_event) && !stopping) {
+			std::this_thread::yield(); //losing one of these leaks a player, wait for the next tick to make room
+		}
+		return;
+	}
+	++droppedEvents; //the tick is far behind, clients resend acks and prediction covers a lost input
+}
+
+/// <summary>
+/// places and removes clients straight away and passes everything else to the room they are in,
+/// no room is ticking yet so nothing here needs a lock
+/// </summary>
+void Server::processNetworkEvents()
+{
+	eventQueueDepth = networkEvents.size();
+	eventQueueDepthMax = std::max(eventQueueDepthMax, eventQueueDepth);
+
+	NetworkEvent event;
+	for (std::size_t drained = 0; drained < networkEvents.capacity() && networkEvents.tryPop(event); ++drained) { //a flood cannot keep the tick here forever
+		switch (event.type)
+		{
+		case NetworkEventType::Connected:
+			handleClientJoined(event.connection);
+			break;
+		case NetworkEventType::Disconnected:
+			handleClientLeft(event.connection);
+			break;
+		default:
+			routeEvent(event);
+			break;
+		}
+	}
+}
+
+/// <summary>
+/// gives a new client a token and a player in the first room with space, otherwise turns them away
+/// </summary>
+void Server::handleClientJoined(ConnectionID _connection)
+{
+	Room* room = findOpenRoom();
+	if (room == nullptr) {
+		std::cout << "Every room is full, turning client away." << "\n";
+		reactor.disconnect(_connection);
+		return;
+	}
+
+	std::uint32_t token;
+	do {
+		token = tokenGenerator();
+	} while (token == 0 || udpTokens.count(token) != 0);
+
+	if (!room->addClient(_connection, token)) {
+		reactor.disconnect(_connection);
+		return;
+	}
+	udpTokens[token] = _connection;
+	connectionRooms[_connection] = { room, token };
+}
+
+void Server::handleClientLeft(ConnectionID _connection)
+{
+	auto it = connectionRooms.find(_connection);
+	if (it == connectionRooms.end()) {
+		return; //was turned away before getting a player
+	}
+	it->second.room->removeClient(_connection);
+	udpTokens.erase(it->second.udpToken);
+	connectionRooms.erase(it);
+}
+
+/// <summary>
+/// finds the room for an event, udp ones only carry a token so it is turned back into the connection first
+/// </summary>
+void Server::routeEvent(const NetworkEvent& _event)
+{
+	NetworkEvent routed = _event;
+	if (_event.type == NetworkEventType::DatagramHello || _event.type == NetworkEventType::DatagramSnapshotAcked) {
+		auto token = udpTokens.find(_event.udpToken);
+		if (token == udpTokens.end()) {
+			return; //unknown or stale token
+		}
+		routed.connection = token->second;
+	}
+
+	auto it = connectionRooms.find(routed.connection);
+	if (it != connectionRooms.end()) {
+		it->second.room->queueEvent(routed);
+	}
+}
+
+/// <summary>
+/// fills rooms in order so matches have people in them rather than spreading everyone thin
+/// </summary>
+Room* Server::findOpenRoom()
+{
+	for (const std::unique_ptr<Room>& room : rooms) {
+		if (!room->isFull()) {
+			return room.get();
+		}
+	}
+	if (static_cast<int>(rooms.size()) >= config.maxRooms) {
+		return nullptr;
+	}
+	rooms.push_back(std::make_unique<Room>(static_cast<int>(rooms.size()), config, reactor));
+	std::cout << "Opened room " << rooms.back()->getID() << "\n";
+	return rooms.back().get();
+}
+
+/// <summary>
+/// phases are summed over every room so the page stays the same size however many matches run,
+/// clients get their own series since a single laggy one is what usually needs finding
+/// </summary>
+void Server::publishMetrics()
+{
+	TickProfiler phases;
+	DurationHistogram roundTrips;
+	std::size_t roomEvents = 0;
+	for (const std::unique_ptr<Room>& room : rooms) {
+		phases.merge(room->getProfiler());
+		roundTrips.merge(room->getRoundTrips());
+		roomEvents += room->getLastEventCount();
+	}
+
+	MetricsText page;
+	page.describe("tag_server_tick_seconds", "histogram", "Whole server tick, routing events and ticking every room.");
+	page.histogram("tag_server_tick_seconds", "", tickDurations);
+	page.describe("tag_server_tick_overruns_total", "counter", "Ticks that took longer than the tick budget.");
+	page.sample("tag_server_tick_overruns_total", "", overrunTicks);
+	page.describe("tag_server_tick_budget_seconds", "gauge", "Time one tick may take at the configured tick rate.");
+	page.sample("tag_server_tick_budget_seconds", "", 1.0 / config.simulation.tickRate);
+
+	page.describe("tag_room_phase_seconds", "histogram", "Time each room spends in a phase of its tick, summed over rooms.");
+	for (std::size_t i = 0; i < static_cast<std::size_t>(TickPhase::COUNT); ++i) {
+		TickPhase phase = static_cast<TickPhase>(i);
+		page.histogram("tag_room_phase_seconds", std::string("phase=\"") + tickPhaseName(phase) + "\"", phases.getPhase(phase));
+	}
+	page.describe("tag_room_tick_seconds", "histogram", "Whole room ticks, summed over rooms.");
+	page.histogram("tag_room_tick_seconds", "", phases.getTick());
+	page.describe("tag_round_trip_seconds", "histogram", "From a snapshot going out to the client acknowledging it.");
+	page.histogram("tag_round_trip_seconds", "", roundTrips);
+
+	page.describe("tag_event_queue_depth", "gauge", "Network events waiting when the last tick started draining.");
+	page.sample("tag_event_queue_depth", "", static_cast<std::uint64_t>(eventQueueDepth));
+	page.describe("tag_event_queue_depth_max", "gauge", "Deepest the network event queue has been since the last page.");
+	page.sample("tag_event_queue_depth_max", "", static_cast<std::uint64_t>(eventQueueDepthMax));
+	page.describe("tag_room_events", "gauge", "Events the rooms drained on the last tick.");
+	page.sample("tag_room_events", "", static_cast<std::uint64_t>(roomEvents));
+	page.describe("tag_dropped_events_total", "counter", "Inputs and acks lost to a full event queue.");
+	page.sample("tag_dropped_events_total", "", static_cast<std::uint64_t>(droppedEvents));
+	page.describe("tag_superseded_snapshots_total", "counter", "Queued snapshots replaced by a newer one before they were sent.");
+	page.sample("tag_superseded_snapshots_total", "", reactor.getSupersededCount());
+	page.describe("tag_evicted_clients_total", "counter", "Clients dropped for falling too far behind on their sends.");
+	page.sample("tag_evicted_clients_total", "", reactor.getEvictedCount());
+	page.describe("tag_rooms", "gauge", "Rooms open.");
+	page.sample("tag_rooms", "", static_cast<std::uint64_t>(rooms.size()));
+	page.describe("tag_clients", "gauge", "Clients placed in a room.");
+	page.sample("tag_clients", "", static_cast<std::uint64_t>(connectionRooms.size()));
+
+	//every series of a metric has to follow its own type line, so the clients are walked once per metric
+	struct ClientSeries
+	{
+		std::string labels;
+		const ClientSession* session;
+		std::uint64_t queued;
+	};
+	std::vector<ClientSeries> clients;
+	clients.reserve(connectionRooms.size());
+	for (const std::unique_ptr<Room>& room : rooms) {
+		for (const auto& [connection, session] : room->getClients()) {
+			std::string labels = "room=\"" + std::to_string(room->getID()) + "\",player=\"" + std::to_string(session.playerID) + "\"";
+			clients.push_back({ std::move(labels), &session, static_cast<std::uint64_t>(reactor.queuedBytes(connection)) });
+		}
+	}
+	auto clientMetric = [&page, &clients](const char* _name, const char* _type, const char* _help, auto _value) {
+		page.describe(_name, _type, _help);
+		for (const ClientSeries& client : clients) {
+			page.sample(_name, client.labels, _value(client));
+		}
+	};
+	clientMetric("tag_client_bytes_in_total", "counter", "Bytes of messages received from a client.",
+		[](const ClientSeries& _client) { return _client.session->traffic.bytesIn; });
+	clientMetric("tag_client_bytes_out_total", "counter", "Bytes of messages handed to the reactor for a client.",
+		[](const ClientSeries& _client) { return _client.session->traffic.bytesOut; });
+	clientMetric("tag_client_messages_in_total", "counter", "Messages received from a client.",
+		[](const ClientSeries& _client) { return _client.session->traffic.messagesIn; });
+	clientMetric("tag_client_messages_out_total", "counter", "Messages handed to the reactor for a client.",
+		[](const ClientSeries& _client) { return _client.session->traffic.messagesOut; });
+	clientMetric("tag_client_send_queue_bytes", "gauge", "Bytes waiting in a clients send queue.",
+		[](const ClientSeries& _client) { return _client.queued; });
+	clientMetric("tag_client_round_trip_seconds", "gauge", "Smoothed snapshot round trip, 0 until the first ack.",
+		[](const ClientSeries& _client) { return _client.session->roundTripMs / 1000.0; });
+
+	metrics.publish(page.take());
+	eventQueueDepthMax = 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "MetricsServer.h"
+#include "MpscQueue.h"
+#include "NetworkReactor.h"
+#include "Room.h"
+#include "ThreadPool.h"
+
+/// <summary>
+/// authoritative server for any number of matches, the reactor reads clients on its own thread and
+/// tick() places new clients in rooms, hands each room what arrived for it and ticks every room on the pool
+/// used by the headless server and by the windowed host for its own match
+/// </summary>
+class Server
+{
+public:
+	explicit Server(const ServerConfig& _config = ServerConfig());
+	~Server();
+
+	bool start(); //opens the listener and starts the network thread
+	void stop();
+
+	void tick(); //one fixed step, call tickRate times a second
+
+	int addLocalPlayer(); //a player without a connection in the first room, used for the hosts own player
+	void submitLocalInput(int _playerID, int _xDir, int _yDir);
+
+	const Simulation& getSimulation() const { return rooms.front()->getSimulation(); } //the first room, the one the host plays in
+	int getTickRate() const { return config.simulation.tickRate; }
+	std::size_t getClientCount() const { return connectionRooms.size(); }
+	std::size_t getRoomCount() const { return rooms.size(); }
+	std::uint64_t getDroppedEvents() const { return droppedEvents; } //inputs and acks lost to a full queue
+	std::uint64_t getEvictedClients() const { return reactor.getEvictedCount(); } //dropped for not keeping up with their sends
+	const DurationHistogram& getTickDurations() const { return tickDurations; } //whole server ticks, routing and every room
+
+private:
+	/// where a connected client was placed
+	struct Placement
+	{
+		Room* room;
+		std::uint32_t udpToken;
+	};
+
+	void queueNetworkEvent(const NetworkEvent& _event); //called from network threads, never blocks on the tick
+	void processNetworkEvents(); //routes queued network events to their rooms on the simulation thread
+
+	void handleClientJoined(ConnectionID _connection); //places a new client in a room with a free slot
+	void handleClientLeft(ConnectionID _connection);
+	void routeEvent(const NetworkEvent& _event); //hands an event to the room its client is in
+	Room* findOpenRoom(); //first room with a free slot, opens a new one if allowed, nullptr if all are full
+
+	void publishMetrics(); //renders the prometheus page, between ticks only
+
+	ServerConfig config;
+	std::vector<std::unique_ptr<Room>> rooms; //never shrinks, an empty room is refilled before a new one opens
+	ThreadPool pool; //ticks the rooms
+
+	NetworkReactor reactor; //owns the listener and every client socket
+	std::thread networkThread; //runs the reactor
+
+	static const std::size_t EVENT_QUEUE_CAPACITY = 8192; //over a hundred events per client per tick at full rooms
+
+	MpscQueue<NetworkEvent> networkEvents{ EVENT_QUEUE_CAPACITY }; //pushed by network threads, drained each tick
+	std::atomic<std::uint64_t> droppedEvents = 0;
+	std::atomic<bool> stopping = false; //lets a network thread waiting on a full queue give up
+
+	std::unordered_map<ConnectionID, Placement> connectionRooms; //every placed client
+	std::unordered_map<std::uint32_t, ConnectionID> udpTokens; //token handed out to each client, unique across rooms
+
+	std::mt19937 tokenGenerator{ std::random_device{}() };
+
+	using Clock = std::chrono::steady_clock;
+	static constexpr std::chrono::seconds METRICS_INTERVAL{ 1 }; //scrapes see numbers at most this old
+
+	MetricsServer metrics;
+	Clock::time_point nextMetrics{};
+	DurationHistogram tickDurations;
+	std::uint64_t overrunTicks = 0; //took longer than the tick budget
+	std::size_t eventQueueDepth = 0; //waiting when the last tick started draining
+	std::size_t eventQueueDepthMax = 0; //deepest since the last page
+};
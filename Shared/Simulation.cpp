@@ -0,0 +1,607 @@
+#include "Simulation.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace
+{
+	//the world sizes as the simulation sees them, converted once when compiled
+	const Fixed SPEED = Fixed::fromFloat(PLAYER_SPEED);
+	const Fixed MARGIN = Fixed::fromFloat(WRAP_MARGIN);
+	const Fixed TAG_REACH = Fixed::fromFloat(PLAYER_RADIUS * 2.f);
+	const Fixed PICKUP_REACH = Fixed::fromFloat(PICKUP_RADIUS + PLAYER_RADIUS);
+
+	SimulationConfig withSeed(SimulationConfig _config)
+	{
+		while (_config.seed == 0) {
+			_config.seed = (static_cast<std::uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+		}
+		return _config;
+	}
+
+	void writePlayer(ByteWriter& _out, const PlayerState& _player)
+	{
+		_out.write<std::int32_t>(_player.id);
+		_out.write(_player.x.raw);
+		_out.write(_player.y.raw);
+		_out.write<std::uint8_t>((_player.isIt ? 1 : 0) | (_player.invisible ? 2 : 0));
+		_out.write(_player.viewLag);
+	}
+
+	PlayerState readPlayer(ByteReader& _in)
+	{
+		PlayerState player;
+		player.id = _in.read<std::int32_t>();
+		player.x = Fixed::fromRaw(_in.read<std::int32_t>());
+		player.y = Fixed::fromRaw(_in.read<std::int32_t>());
+		std::uint8_t flags = _in.read<std::uint8_t>();
+		player.isIt = (flags & 1) != 0;
+		player.invisible = (flags & 2) != 0;
+		player.viewLag = _in.read<std::uint32_t>();
+		return player;
+	}
+}
+
+Simulation::Simulation(const SimulationConfig& _config) :
+	config(withSeed(_config)),
+	players(static_cast<std::size_t>(std::clamp(_config.maxPlayers, 1, static_cast<int>(SlotID::MAX_SLOTS)))),
+	maxRewindTicks(static_cast<std::uint32_t>(std::lround(_config.maxRewind * _config.tickRate)))
+{
+	random.seed(config.seed);
+	history.resize(maxRewindTicks + 1);
+	queuedInputs.resize(players.capacity());
+	inputTicks.resize(players.capacity());
+	startTimer(Timer::PickUpSpawn, config.pickUpDelay);
+}
+
+/// <summary>
+/// takes a free id and spawns a player for it, the first player in becomes 'IT'
+/// </summary>
+/// <returns>new player id or -1 if there is no room</returns>
+int Simulation::addPlayer()
+{
+	const std::vector<PlayerState>& current = players.getValues();
+	bool needsIt = std::none_of(current.begin(), current.end(), [](const PlayerState& _other) { return _other.isIt; });
+
+	int id = players.insert(PlayerState());
+	if (id == -1) {
+		std::cout << "No available IDs!" << "\n";
+		return -1;
+	}
+	std::cout << "Assigned ID: " << id << "\n";
+
+	PlayerState& player = *players.find(id);
+	player.id = id;
+	SpawnPoint spawn = spawnPoint(id); //set his spawn
+	player.x = spawn.x;
+	player.y = spawn.y;
+	player.isIt = needsIt;
+
+	survivalTicks = 0; //start game time
+	return id;
+}
+
+/// <summary>
+/// removes a player and frees their slot, hands 'IT' on if they had it
+/// the id is never handed out again so late packets for it find nobody
+/// </summary>
+void Simulation::removePlayer(int _id)
+{
+	const PlayerState* player = players.find(_id);
+	if (player == nullptr) {
+		return;
+	}
+	bool wasIt = player->isIt;
+	players.erase(_id);
+	playerGrid.remove(_id);
+
+	if (wasIt && !players.empty()) {
+		PlayerState& next = players.getValues().front();
+		next.isIt = true;
+	}
+}
+
+void Simulation::queueInput(int _playerID, int _xDir, int _yDir, std::uint64_t _viewTick, std::uint32_t _sequence)
+{
+	if (players.find(_playerID) == nullptr) {
+		return; //left already
+	}
+	std::uint8_t& queued = queuedInputs[SlotID::index(_playerID)];
+	if (queued >= MAX_QUEUED_INPUTS) {
+		for (auto it = pendingInputs.rbegin(); it != pendingInputs.rend(); ++it) {
+			if (it->playerID == _playerID) {
+				*it = { _playerID, _xDir, _yDir, _viewTick, _sequence }; //a flood loses moves rather than piling them up
+				return;
+			}
+		}
+	}
+	++queued;
+	pendingInputs.push_back({ _playerID, _xDir, _yDir, _viewTick, _sequence });
+}
+
+/// <summary>
+/// one fixed tick of the match
+/// timers fire after the tag check so a tag on the tick a pickup was due still stops it spawning
+/// </summary>
+void Simulation::step()
+{
+	++tick;
+
+	if (currentState == MatchState::Playing) {
+
+		++survivalTicks; //time for endgame message
+
+		applyInputs();
+
+		updateGrid();
+		lap(TickPhase::Movement);
+		collisionCheck(); //collision between players
+		lap(TickPhase::Collision);
+	}
+	else {
+		dropInputs(); //frozen, nobody moves
+	}
+
+	timers.advance(tick, [this](Timer _timer) { onTimer(_timer); }); //pickup spawns, invisibility ends and restarts
+	if (currentState == MatchState::Playing && pickUp.active) {
+		handlePickUpCollision();
+	}
+	lap(TickPhase::PickUp);
+
+	recordHistory();
+	lap(TickPhase::Collision); //the history only exists for collisionCheck to rewind
+}
+
+bool Simulation::applyMovement(PlayerState& _player, int _xDir, int _yDir)
+{
+	_player.x += SPEED * std::clamp(_xDir, -1, 1);
+	_player.y += SPEED * std::clamp(_yDir, -1, 1);
+
+	return handleBoundary(_player);
+}
+
+/// <summary>
+/// keeps players inside the screen by wrapping them to the other side
+/// </summary>
+/// <returns>true if the player wrapped</returns>
+bool Simulation::handleBoundary(PlayerState& _player)
+{
+	const Fixed right = Fixed::fromInt(SCREEN_WIDTH) + MARGIN;
+	const Fixed bottom = Fixed::fromInt(SCREEN_HEIGHT) + MARGIN;
+	if (_player.x < -MARGIN) {
+		_player.x = right;
+	}
+	else if (_player.x > right) {
+		_player.x = -MARGIN;
+	}
+	else if (_player.y < -MARGIN) {
+		_player.y = bottom;
+	}
+	else if (_player.y > bottom) {
+		_player.y = -MARGIN;
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+const PlayerState* Simulation::findPlayer(int _id) const
+{
+	return players.find(_id);
+}
+
+PlayerState* Simulation::findMutablePlayer(int _id)
+{
+	return players.find(_id);
+}
+
+/// <summary>
+/// applies every queued input in the order it arrived
+/// </summary>
+void Simulation::applyInputs()
+{
+	carriedInputs.clear();
+	for (const QueuedInput& input : pendingInputs) {
+		std::size_t slot = SlotID::index(input.playerID);
+		PlayerState* player = findMutablePlayer(input.playerID);
+		if (player != nullptr && inputTicks[slot] == tick) {
+			carriedInputs.push_back(input); //moved this tick already, the rewind search relies on one move a tick
+			continue;
+		}
+		--queuedInputs[slot];
+		if (player == nullptr) {
+			continue; //left already
+		}
+		inputTicks[slot] = tick;
+		player->appliedInput = input.sequence;
+		if (input.viewTick != 0) {
+			std::uint64_t lag = tick > input.viewTick ? tick - input.viewTick : 0; //a view from the future is a bad clock, treat it as now
+			player->viewLag = static_cast<std::uint32_t>(std::min<std::uint64_t>(lag, maxRewindTicks));
+		}
+		if (input.xDir == 0 && input.yDir == 0) {
+			continue; //standing still
+		}
+		applyMovement(*player, input.xDir, input.yDir);
+	}
+	std::swap(pendingInputs, carriedInputs);
+}
+
+void Simulation::dropInputs()
+{
+	for (const QueuedInput& input : pendingInputs) {
+		PlayerState* player = findMutablePlayer(input.playerID);
+		if (player != nullptr) {
+			player->appliedInput = input.sequence; //acked so the client stops predicting it
+		}
+	}
+	pendingInputs.clear();
+	std::fill(queuedInputs.begin(), queuedInputs.end(), 0);
+}
+
+void Simulation::updateGrid()
+{
+	for (const PlayerState& player : players.getValues()) {
+		playerGrid.update(player.id, player.x, player.y);
+	}
+}
+
+/// <summary>
+/// checks if 'IT' has touched anyone, circles overlapping like the shapes drawn
+/// 'IT' is where they are now but the others are where 'IT' saw them,
+/// so a tag that looked right on a lagging screen still counts
+/// </summary>
+void Simulation::collisionCheck()
+{
+	const std::int64_t reachSquared = squaredLength(TAG_REACH, Fixed());
+	for (const PlayerState& checkingPlayer : players.getValues()) //pick out start player
+	{
+		if (!checkingPlayer.isIt) {
+			continue;
+		}
+		std::uint64_t viewTick = tick - std::min<std::uint64_t>(checkingPlayer.viewLag, tick);
+
+		//the grid holds where everyone is now, widen the search by how far they could have walked since viewTick
+		//a player who wrapped in that time is missed, they were at the screen edge so it hardly matters
+		candidates.clear();
+		playerGrid.query(checkingPlayer.x, checkingPlayer.y, TAG_REACH + SPEED * static_cast<std::int32_t>(checkingPlayer.viewLag), candidates);
+		for (int otherID : candidates)
+		{
+			const PlayerState* otherPlayer = findPlayer(otherID);
+			if (otherID == checkingPlayer.id || otherPlayer == nullptr) {
+				continue;
+			}
+			const PlayerState& seen = rewind(*otherPlayer, viewTick);
+			if (squaredLength(checkingPlayer.x - seen.x, checkingPlayer.y - seen.y) < reachSquared)
+			{
+				std::cout << "Collision" << "\n";
+				currentState = MatchState::GameOver; //end game
+				stopTimer(Timer::PickUpSpawn); //frozen, the restart sets them going again
+				stopTimer(Timer::InvisibilityEnd);
+				startTimer(Timer::Restart, config.gameOverDelay);
+
+				for (PlayerState& player : players.getValues())
+				{
+					player.invisible = false; //make player visibile if he wasnt
+				}
+				return;
+			}
+		}
+	}
+}
+
+void Simulation::recordHistory()
+{
+	HistoryFrame& frame = history[tick % history.size()];
+	frame.tick = tick;
+	PlayerState nobody;
+	nobody.id = -1;
+	frame.players.assign(players.capacity(), nobody);
+	for (const PlayerState& player : players.getValues()) {
+		frame.players[SlotID::index(player.id)] = player;
+	}
+}
+
+const PlayerState& Simulation::rewind(const PlayerState& _player, std::uint64_t _tick) const
+{
+	const HistoryFrame& frame = history[_tick % history.size()];
+	if (_tick == tick || frame.tick != _tick) {
+		return _player; //the present, or too old to have been kept
+	}
+	const PlayerState& past = frame.players[SlotID::index(_player.id)];
+	return past.id == _player.id ? past : _player; //someone else had the slot then, so they joined since
+}
+
+/// <summary>
+/// restarts the game from the beginning
+/// </summary>
+void Simulation::resetGame()
+{
+	std::vector<PlayerState>& current = players.getValues();
+	int randomIt = static_cast<int>(random.below(static_cast<std::uint32_t>(current.size()))); //pick a random person to be 'IT'
+	for (int i = 0; i < static_cast<int>(current.size()); i++)
+	{
+		SpawnPoint spawn = spawnPoint(current[i].id);
+		current[i].x = spawn.x;
+		current[i].y = spawn.y;
+		current[i].isIt = (i == randomIt);
+		current[i].invisible = false;
+	}
+	survivalTicks = 0;
+
+	isInvisible = false;
+	pickUp.active = false;
+	startTimer(Timer::PickUpSpawn, config.pickUpDelay);
+
+	currentState = MatchState::Playing;
+}
+
+/// <summary>
+/// spawns pick up when its timer fires, the timer only runs while there is no pickup and nobody is invisible
+/// </summary>
+void Simulation::handlePickUp()
+{
+	pickUp.x = Fixed::fromInt(static_cast<std::int32_t>(random.below(SCREEN_WIDTH - 200)) + 100); //keep within screen
+	pickUp.y = Fixed::fromInt(static_cast<std::int32_t>(random.below(SCREEN_HEIGHT - 200)) + 100);
+	pickUp.active = true;
+}
+
+/// <summary>
+/// checks if any active players have colided with the pick up and starts their effect
+/// </summary>
+void Simulation::handlePickUpCollision()
+{
+	const std::int64_t reachSquared = squaredLength(PICKUP_REACH, Fixed());
+	candidates.clear();
+	playerGrid.query(pickUp.x, pickUp.y, PICKUP_REACH, candidates);
+	std::sort(candidates.begin(), candidates.end()); //lowest id wins a tie whatever cell order the grid gave
+
+	for (int id : candidates)
+	{
+		PlayerState* player = findMutablePlayer(id);
+		if (squaredLength(pickUp.x - player->x, pickUp.y - player->y) < reachSquared)
+		{
+			isInvisible = true;
+			player->invisible = true;
+			pickUp.active = false; //delete pick up
+			if (secondsToTicks(config.invisibilityDuration) == 0) {
+				handlePickUpEffect(); //no duration wears off the tick it is picked up
+			}
+			else {
+				startTimer(Timer::InvisibilityEnd, config.invisibilityDuration);
+			}
+			return;
+		}
+	}
+}
+
+/// <summary>
+/// reset invisibility once it runs out so everyone reappears
+/// </summary>
+void Simulation::handlePickUpEffect()
+{
+	for (PlayerState& player : players.getValues())
+	{
+		player.invisible = false;
+	}
+	isInvisible = false;
+	startTimer(Timer::PickUpSpawn, config.pickUpDelay);
+}
+
+/// <summary>
+/// a timer is due a tick later at the soonest, as when these were deadlines checked on the following step
+/// </summary>
+void Simulation::startTimer(Timer _timer, float _seconds)
+{
+	stopTimer(_timer);
+	PendingTimer& pending = pendingTimers[static_cast<std::size_t>(_timer)];
+	pending.tick = tick + std::max<std::uint64_t>(1, secondsToTicks(_seconds));
+	pending.handle = timers.schedule(pending.tick, _timer);
+}
+
+void Simulation::stopTimer(Timer _timer)
+{
+	PendingTimer& pending = pendingTimers[static_cast<std::size_t>(_timer)];
+	if (pending.handle != TimerWheel<Timer>::NONE) {
+		timers.cancel(pending.handle);
+		pending.handle = TimerWheel<Timer>::NONE;
+	}
+}
+
+void Simulation::onTimer(Timer _timer)
+{
+	pendingTimers[static_cast<std::size_t>(_timer)].handle = TimerWheel<Timer>::NONE; //fired, the wheel has let the handle go
+	switch (_timer)
+	{
+	case Timer::PickUpSpawn:
+		handlePickUp();
+		break;
+	case Timer::InvisibilityEnd:
+		handlePickUpEffect();
+		break;
+	case Timer::Restart:
+		resetGame();
+		break;
+	default:
+		break;
+	}
+}
+
+/// <summary>
+/// keyframes keep only the ticks, which timer is pending follows from the match state
+/// </summary>
+void Simulation::rebuildTimers()
+{
+	timers.clear(tick + 1);
+	for (PendingTimer& pending : pendingTimers) {
+		pending.handle = TimerWheel<Timer>::NONE;
+	}
+	Timer running = currentState == MatchState::GameOver ? Timer::Restart
+		: isInvisible ? Timer::InvisibilityEnd
+		: !pickUp.active ? Timer::PickUpSpawn
+		: Timer::COUNT;
+	if (running != Timer::COUNT) {
+		PendingTimer& pending = pendingTimers[static_cast<std::size_t>(running)];
+		pending.handle = timers.schedule(pending.tick, running);
+	}
+}
+
+std::uint64_t Simulation::secondsToTicks(float _seconds) const
+{
+	return static_cast<std::uint64_t>(std::ceil(_seconds * config.tickRate));
+}
+
+/// <summary>
+/// walks the R2 low discrepancy sequence by slot, each new point lands in the biggest gap the earlier ones left
+/// so a small room is spread across the screen and a big one fills it evenly
+/// </summary>
+Simulation::SpawnPoint Simulation::spawnPoint(int _id)
+{
+	const std::int32_t margin = 100; //clear of the wrap edges
+	const std::uint32_t stepX = 3242174889u; //1 / plastic number and its square, as fractions of 2^32
+	const std::uint32_t stepY = 2447445414u;
+
+	std::uint32_t n = static_cast<std::uint32_t>(SlotID::index(_id)) + 1;
+	std::uint64_t fractionX = static_cast<std::uint32_t>(0x80000000u + stepX * n); //unsigned wraps round at 1 by itself
+	std::uint64_t fractionY = static_cast<std::uint32_t>(0x80000000u + stepY * n);
+	std::uint64_t spanX = static_cast<std::uint64_t>(SCREEN_WIDTH - margin * 2) << Fixed::FRACTION_BITS;
+	std::uint64_t spanY = static_cast<std::uint64_t>(SCREEN_HEIGHT - margin * 2) << Fixed::FRACTION_BITS;
+	return { Fixed::fromInt(margin) + Fixed::fromRaw(static_cast<std::int32_t>((fractionX * spanX) >> 32)),
+		Fixed::fromInt(margin) + Fixed::fromRaw(static_cast<std::int32_t>((fractionY * spanY) >> 32)) };
+}
+
+/// <summary>
+/// the generator is saved with the rest so a replay restored from here steps exactly as the original did
+/// </summary>
+void Simulation::saveState(ByteWriter& _out) const
+{
+	_out.write(tick);
+	for (const PendingTimer& pending : pendingTimers) {
+		_out.write(pending.tick);
+	}
+	_out.write(survivalTicks);
+	for (std::uint32_t word : random.getState()) {
+		_out.write(word);
+	}
+	_out.write<std::uint8_t>(currentState == MatchState::GameOver ? 1 : 0);
+	_out.write<std::uint8_t>(isInvisible ? 1 : 0);
+	_out.write<std::uint8_t>(pickUp.active ? 1 : 0);
+	_out.write(pickUp.x.raw);
+	_out.write(pickUp.y.raw);
+
+	SlotMap<PlayerState>::Layout layout = players.getLayout();
+	_out.writeVarUint(layout.generations.size());
+	for (std::uint32_t generation : layout.generations) {
+		_out.writeVarUint(generation);
+	}
+	_out.writeVarUint(layout.freeOrder.size());
+	for (std::size_t index : layout.freeOrder) {
+		_out.writeVarUint(index);
+	}
+	_out.writeVarUint(layout.valueIDs.size());
+	for (const PlayerState& player : players.getValues()) {
+		writePlayer(_out, player); //ids are in the players
+	}
+
+	_out.writeVarUint(pendingInputs.size()); //carried over from the step just taken
+	for (const QueuedInput& input : pendingInputs) {
+		_out.write<std::int32_t>(input.playerID);
+		_out.write<std::int8_t>(static_cast<std::int8_t>(input.xDir));
+		_out.write<std::int8_t>(static_cast<std::int8_t>(input.yDir));
+		_out.write(input.viewTick);
+	}
+
+	_out.writeVarUint(history.size());
+	for (const HistoryFrame& frame : history) {
+		_out.write(frame.tick);
+		_out.writeVarUint(frame.players.size());
+		for (const PlayerState& player : frame.players) {
+			writePlayer(_out, player);
+		}
+	}
+}
+
+bool Simulation::loadState(ByteReader& _in)
+{
+	tick = _in.read<std::uint64_t>();
+	for (PendingTimer& pending : pendingTimers) {
+		pending.tick = _in.read<std::uint64_t>();
+	}
+	survivalTicks = _in.read<std::uint64_t>();
+	Xoshiro128::State state;
+	for (std::uint32_t& word : state) {
+		word = _in.read<std::uint32_t>();
+	}
+	random.setState(state);
+	currentState = _in.read<std::uint8_t>() != 0 ? MatchState::GameOver : MatchState::Playing;
+	isInvisible = _in.read<std::uint8_t>() != 0;
+	pickUp.active = _in.read<std::uint8_t>() != 0;
+	pickUp.x = Fixed::fromRaw(_in.read<std::int32_t>());
+	pickUp.y = Fixed::fromRaw(_in.read<std::int32_t>());
+
+	SlotMap<PlayerState>::Layout layout;
+	std::uint64_t slots = _in.readVarUint();
+	if (slots != players.capacity()) {
+		return false;
+	}
+	for (std::uint64_t i = 0; i < slots; ++i) {
+		layout.generations.push_back(static_cast<std::uint32_t>(_in.readVarUint()));
+	}
+	std::uint64_t freeCount = _in.readVarUint();
+	for (std::uint64_t i = 0; i < freeCount && i < slots && !_in.failed(); ++i) {
+		layout.freeOrder.push_back(static_cast<std::size_t>(_in.readVarUint()));
+	}
+	std::uint64_t playerCount = _in.readVarUint();
+	std::vector<PlayerState> values;
+	for (std::uint64_t i = 0; i < playerCount && i < slots && !_in.failed(); ++i) {
+		values.push_back(readPlayer(_in));
+		layout.valueIDs.push_back(values.back().id);
+	}
+	if (_in.failed() || !players.restore(layout, std::move(values))) {
+		return false;
+	}
+
+	pendingInputs.clear();
+	std::fill(queuedInputs.begin(), queuedInputs.end(), 0);
+	std::fill(inputTicks.begin(), inputTicks.end(), 0);
+	std::uint64_t inputCount = _in.readVarUint();
+	if (inputCount > slots * MAX_QUEUED_INPUTS) {
+		return false;
+	}
+	for (std::uint64_t i = 0; i < inputCount; ++i) {
+		QueuedInput input{};
+		input.playerID = _in.read<std::int32_t>();
+		input.xDir = _in.read<std::int8_t>();
+		input.yDir = _in.read<std::int8_t>();
+		input.viewTick = _in.read<std::uint64_t>();
+		if (_in.failed() || players.find(input.playerID) == nullptr) {
+			return false;
+		}
+		++queuedInputs[SlotID::index(input.playerID)];
+		pendingInputs.push_back(input);
+	}
+
+	if (_in.readVarUint() != history.size()) {
+		return false;
+	}
+	for (HistoryFrame& frame : history) {
+		frame.tick = _in.read<std::uint64_t>();
+		std::uint64_t size = _in.readVarUint();
+		if (size > players.capacity()) {
+			return false;
+		}
+		frame.players.resize(static_cast<std::size_t>(size));
+		for (PlayerState& player : frame.players) {
+			player = readPlayer(_in);
+		}
+	}
+	if (_in.failed()) {
+		return false;
+	}
+
+	playerGrid.clear();
+	updateGrid();
+	rebuildTimers();
+	return true;
+}
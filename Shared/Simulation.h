@@ -0,0 +1,196 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "ByteStream.h"
+#include "FixedPoint.h"
+#include "Random.h"
+#include "SlotMap.h"
+#include "SpatialHash.h"
+#include "TickProfiler.h"
+#include "TimerWheel.h"
+#include "WorldConstants.h"
+
+/// <summary>
+/// state of one player as the simulation sees it, no rendering data
+/// </summary>
+struct PlayerState
+{
+	int id = 0;
+	Fixed x;
+	Fixed y;
+	bool isIt = false;
+	bool invisible = false;
+	std::uint32_t viewLag = 0; //ticks behind the present this player sees the others, from their last input
+	std::uint32_t appliedInput = 0; //sequence of the newest input used up, what the host acks, not kept in keyframes
+};
+
+struct PickUpState
+{
+	bool active = false;
+	Fixed x;
+	Fixed y;
+};
+
+enum class MatchState
+{
+	Playing,
+	GameOver
+};
+
+struct SimulationConfig
+{
+	int tickRate = 60; //steps per second
+	int maxPlayers = 32; //room size, at most SlotID::MAX_SLOTS
+	float pickUpDelay = 3.f; //seconds without a pickup before one spawns
+	float invisibilityDuration = 1.5f;
+	float gameOverDelay = 3.f; //freeze after a tag before the restart
+	float maxRewind = 0.25f; //furthest back in seconds a tag is checked against, caps what a laggy tagger gets away with
+	std::uint64_t seed = 0; //decides pickup spots and who is it after a tag, 0 draws a fresh one
+};
+
+/// <summary>
+/// authoritative game of tag advanced in fixed ticks
+/// has no window or sockets so it runs the same in the host, the headless server and tools
+/// positions are fixed point and randomness comes from the match's own seeded generator, so the same
+/// config and inputs step to the same bits anywhere, which replays, lockstep and rollback rely on
+/// </summary>
+class Simulation
+{
+public:
+	explicit Simulation(const SimulationConfig& _config = SimulationConfig());
+
+	int addPlayer(); //returns the new id, -1 if the room is full
+	int getMaxPlayers() const { return static_cast<int>(players.capacity()); }
+	void removePlayer(int _id);
+
+	/// <summary>
+	/// applied in order, one a tick for each player, so a player moves at the tick rate however fast inputs arrive
+	/// </summary>
+	/// <param name="_viewTick">tick the player was seeing the others at when they sent it, 0 for no lag</param>
+	/// <param name="_sequence">becomes the player's appliedInput once used up</param>
+	void queueInput(int _playerID, int _xDir, int _yDir, std::uint64_t _viewTick = 0, std::uint32_t _sequence = 0);
+	void step(); //advance one tick
+
+	/// <summary>
+	/// moves a player by one input and wraps them at the screen edges
+	/// </summary>
+	/// <returns>true if the player wrapped</returns>
+	static bool applyMovement(PlayerState& _player, int _xDir, int _yDir);
+	static bool handleBoundary(PlayerState& _player); //wraps a player that has gone off screen
+
+	const std::vector<PlayerState>& getPlayers() const { return players.getValues(); } //no particular order
+	const PlayerState* findPlayer(int _id) const;
+	const PickUpState& getPickUp() const { return pickUp; }
+	MatchState getState() const { return currentState; }
+	float getSurvivalTime() const { return static_cast<float>(survivalTicks) / config.tickRate; } //seconds, for display
+	std::uint64_t getTick() const { return tick; }
+	const SimulationConfig& getConfig() const { return config; } //with the seed actually used
+
+	void setProfiler(TickProfiler* _profiler) { profiler = _profiler; } //times the phases of step, nullptr for none
+
+	/// <summary>
+	/// everything the next step depends on, for keyframes, the grid is rebuilt from the players on load
+	/// </summary>
+	void saveState(ByteWriter& _out) const;
+	bool loadState(ByteReader& _in); //false if malformed or saved by a room of another size, the state is then undefined
+
+private:
+	enum class Timer
+	{
+		PickUpSpawn, //no pickup until it fires
+		InvisibilityEnd,
+		Restart, //game over until it fires
+		COUNT
+	};
+
+	/// the one of each timer that can be pending, its tick is kept for keyframes
+	struct PendingTimer
+	{
+		std::uint64_t tick = 0;
+		int handle = TimerWheel<Timer>::NONE;
+	};
+
+	struct SpawnPoint
+	{
+		Fixed x;
+		Fixed y;
+	};
+
+	struct QueuedInput
+	{
+		int playerID;
+		int xDir;
+		int yDir;
+		std::uint64_t viewTick;
+		std::uint32_t sequence;
+	};
+
+	/// positions of every player at the end of one tick
+	struct HistoryFrame
+	{
+		std::uint64_t tick = 0;
+		std::vector<PlayerState> players; //by slot, id -1 where nobody was
+	};
+
+	PlayerState* findMutablePlayer(int _id);
+
+	void applyInputs(); //one for each player, the rest wait for the next tick
+	void dropInputs(); //frozen, everything queued is used up without moving
+
+	void updateGrid(); //moves players that changed cell
+	void collisionCheck(); //checks collision amoung players
+
+	void recordHistory(); //keeps this ticks positions for collisionCheck to rewind to
+	const PlayerState& rewind(const PlayerState& _player, std::uint64_t _tick) const; //where _player was at _tick, now if not kept
+
+	void resetGame(); //resets game back to start
+
+	//pickups
+	void handlePickUp(); //spawns pickup
+	void handlePickUpCollision(); //pickup collision
+	void handlePickUpEffect(); //ends the effect
+
+	void startTimer(Timer _timer, float _seconds); //from this tick, replaces the pending one
+	void stopTimer(Timer _timer);
+	void onTimer(Timer _timer);
+	void rebuildTimers(); //after a load, from the ticks and the state they belong to
+
+	void lap(TickPhase _phase)
+	{
+		if (profiler != nullptr) {
+			profiler->lap(_phase);
+		}
+	}
+
+	std::uint64_t secondsToTicks(float _seconds) const;
+	static SpawnPoint spawnPoint(int _id); //same spot for a slot every time, neighbouring slots spread out
+
+	SimulationConfig config;
+
+	SlotMap<PlayerState> players;
+	std::vector<QueuedInput> pendingInputs;
+	std::vector<QueuedInput> carriedInputs; //swapped with pendingInputs each tick
+	std::vector<std::uint8_t> queuedInputs; //by slot, waiting in pendingInputs
+	std::vector<std::uint64_t> inputTicks; //by slot, tick the last input was applied on
+	static const std::uint8_t MAX_QUEUED_INPUTS = 4; //ticks of movement a player may have waiting, more replace the newest
+
+	std::vector<HistoryFrame> history; //ring indexed by tick, frames are reused so recording does not allocate
+	std::uint32_t maxRewindTicks;
+
+	SpatialHash playerGrid{ Fixed::fromFloat(PLAYER_RADIUS * 4.f) }; //a tag reaches two radii so one cell either side covers it
+	std::vector<int> candidates; //reused by every grid query
+
+	PickUpState pickUp;
+	bool isInvisible = false;
+
+	MatchState currentState = MatchState::Playing;
+	std::uint64_t survivalTicks = 0; //end game timer
+
+	TickProfiler* profiler = nullptr;
+	Xoshiro128 random; //this match's only source of randomness
+
+	std::uint64_t tick = 0;
+	TimerWheel<Timer> timers{ 1 }; //the first step is tick 1
+	std::array<PendingTimer, static_cast<std::size_t>(Timer::COUNT)> pendingTimers;
+};
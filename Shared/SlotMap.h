@@ -0,0 +1,192 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+/// <summary>
+/// ids handed out by a SlotMap, the low bits pick the slot and the rest count how often it has been reused
+/// so an id kept after its owner left never matches whoever gets the slot next
+/// </summary>
+namespace SlotID
+{
+	const int INDEX_BITS = 10;
+	const std::size_t MAX_SLOTS = std::size_t{ 1 } << INDEX_BITS;
+	const std::uint32_t GENERATION_MASK = (std::uint32_t{ 1 } << (31 - INDEX_BITS)) - 1; //keeps ids positive
+
+	inline std::size_t index(std::int32_t _id) { return static_cast<std::size_t>(_id) & (MAX_SLOTS - 1); }
+	inline std::uint32_t generation(std::int32_t _id) { return static_cast<std::uint32_t>(_id) >> INDEX_BITS; }
+	inline std::int32_t make(std::size_t _index, std::uint32_t _generation)
+	{
+		return static_cast<std::int32_t>(((_generation & GENERATION_MASK) << INDEX_BITS) | static_cast<std::uint32_t>(_index));
+	}
+}
+
+/// <summary>
+/// fixed number of slots with O(1) insert, erase and lookup by id
+/// values are kept packed in one vector so looping over them is as quick as a plain vector,
+/// erasing moves the last value into the gap so the order is not kept
+/// </summary>
+template <typename T>
+class SlotMap
+{
+public:
+	explicit SlotMap(std::size_t _capacity) :
+		slots(_capacity < SlotID::MAX_SLOTS ? _capacity : SlotID::MAX_SLOTS)
+	{
+		for (std::size_t i = 0; i < slots.size(); ++i) {
+			freeSlots.push(i); //oldest freed slot is reused first so generations wrap as late as possible
+		}
+		values.reserve(slots.size());
+		valueIDs.reserve(slots.size());
+	}
+
+	/// <summary>
+	/// stores the value in a free slot
+	/// </summary>
+	/// <returns>id of the new value, -1 if every slot is taken</returns>
+	std::int32_t insert(const T& _value)
+	{
+		if (freeSlots.empty()) {
+			return -1;
+		}
+		std::size_t index = freeSlots.front();
+		freeSlots.pop();
+
+		Slot& slot = slots[index];
+		slot.valueIndex = values.size();
+		slot.occupied = true;
+		std::int32_t id = SlotID::make(index, slot.generation);
+		values.push_back(_value);
+		valueIDs.push_back(id);
+		return id;
+	}
+
+	bool erase(std::int32_t _id)
+	{
+		Slot* slot = findSlot(_id);
+		if (slot == nullptr) {
+			return false;
+		}
+		std::size_t gap = slot->valueIndex;
+		if (gap != values.size() - 1) {
+			values[gap] = std::move(values.back());
+			valueIDs[gap] = valueIDs.back();
+			slots[SlotID::index(valueIDs[gap])].valueIndex = gap;
+		}
+		values.pop_back();
+		valueIDs.pop_back();
+
+		slot->occupied = false;
+		slot->generation = (slot->generation + 1) & SlotID::GENERATION_MASK;
+		freeSlots.push(SlotID::index(_id));
+		return true;
+	}
+
+	T* find(std::int32_t _id)
+	{
+		Slot* slot = findSlot(_id);
+		return slot == nullptr ? nullptr : &values[slot->valueIndex];
+	}
+
+	const T* find(std::int32_t _id) const
+	{
+		return const_cast<SlotMap*>(this)->find(_id);
+	}
+
+	std::vector<T>& getValues() { return values; }
+	const std::vector<T>& getValues() const { return values; }
+
+	std::size_t size() const { return values.size(); }
+	std::size_t capacity() const { return slots.size(); }
+	bool empty() const { return values.empty(); }
+	bool full() const { return freeSlots.empty(); }
+
+	/// the bookkeeping behind the ids, a map restored from it hands out the same ids in the same order
+	struct Layout
+	{
+		std::vector<std::uint32_t> generations; //per slot
+		std::vector<std::size_t> freeOrder; //free slots, next to be reused first
+		std::vector<std::int32_t> valueIDs; //id of each value in order
+	};
+
+	Layout getLayout() const
+	{
+		Layout layout;
+		layout.generations.reserve(slots.size());
+		for (const Slot& slot : slots) {
+			layout.generations.push_back(slot.generation);
+		}
+		std::queue<std::size_t> pending = freeSlots;
+		while (!pending.empty()) {
+			layout.freeOrder.push_back(pending.front());
+			pending.pop();
+		}
+		layout.valueIDs = valueIDs;
+		return layout;
+	}
+
+	/// <summary>
+	/// replaces everything with a saved layout and its values
+	/// </summary>
+	/// <returns>false if the layout does not describe a map of this capacity, nothing is changed</returns>
+	bool restore(const Layout& _layout, std::vector<T> _values)
+	{
+		if (_layout.generations.size() != slots.size() || _layout.valueIDs.size() != _values.size() ||
+			_layout.freeOrder.size() + _values.size() != slots.size()) {
+			return false;
+		}
+		std::vector<Slot> restored(slots.size());
+		std::vector<bool> seen(slots.size(), false);
+		for (std::size_t i = 0; i < restored.size(); ++i) {
+			restored[i].generation = _layout.generations[i] & SlotID::GENERATION_MASK;
+		}
+		for (std::size_t i = 0; i < _layout.valueIDs.size(); ++i) {
+			std::int32_t id = _layout.valueIDs[i];
+			std::size_t index = SlotID::index(id);
+			if (id < 0 || index >= restored.size() || seen[index] || SlotID::generation(id) != restored[index].generation) {
+				return false;
+			}
+			seen[index] = true;
+			restored[index].occupied = true;
+			restored[index].valueIndex = i;
+		}
+		for (std::size_t index : _layout.freeOrder) {
+			if (index >= restored.size() || seen[index]) {
+				return false;
+			}
+			seen[index] = true;
+		}
+
+		slots = std::move(restored);
+		freeSlots = std::queue<std::size_t>();
+		for (std::size_t index : _layout.freeOrder) {
+			freeSlots.push(index);
+		}
+		values = std::move(_values);
+		valueIDs = _layout.valueIDs;
+		return true;
+	}
+
+private:
+	struct Slot
+	{
+		std::uint32_t generation = 0;
+		std::size_t valueIndex = 0;
+		bool occupied = false;
+	};
+
+	Slot* findSlot(std::int32_t _id)
+	{
+		if (_id < 0 || SlotID::index(_id) >= slots.size()) {
+			return nullptr;
+		}
+		Slot& slot = slots[SlotID::index(_id)];
+		return slot.occupied && slot.generation == SlotID::generation(_id) ? &slot : nullptr;
+	}
+
+	std::vector<Slot> slots;
+	std::queue<std::size_t> freeSlots;
+	std::vector<T> values;
+	std::vector<std::int32_t> valueIDs;
+};
@@ -0,0 +1,217 @@
+#include "Snapshot.h"
+
+/// layout after the fixed SnapshotMessage, all bit packed:
+/// pickup changed bit [active bit, x, y], match changed bit [game over bit, survival millis],
+/// then per changed player a 1 bit, the slot gap from the last entry, a removed bit
+/// and unless removed a fresh bit with the id generation when someone new has the slot,
+/// x changed, y changed, isIt and invisible bits then the changed positions,
+/// a 0 bit ends the list
+
+std::size_t encodeSnapshotDelta(const Snapshot& _baseline, const Snapshot& _current, std::uint32_t _lastInput, std::uint32_t _sequence, char* _out)
+{
+	std::size_t changes = encodeSnapshotChanges(_baseline, _current, _out + SNAPSHOT_PREFIX_SIZE);
+	if (changes == 0) {
+		return 0;
+	}
+	encodeSnapshotPrefix(_baseline.tick, _current.tick, _lastInput, _sequence, changes, _out);
+	return SNAPSHOT_PREFIX_SIZE + changes;
+}
+
+void encodeSnapshotPrefix(std::uint32_t _baselineTick, std::uint32_t _tick, std::uint32_t _lastInput, std::uint32_t _sequence, std::size_t _changesSize, char* _out)
+{
+	SnapshotMessage fixed{ _tick, _baselineTick, _lastInput };
+	std::memcpy(_out + sizeof(MessageHeader), &fixed, sizeof(fixed));
+	encodeHeader(MessageType::Snapshot, sizeof(SnapshotMessage) + _changesSize, _sequence, _out);
+}
+
+std::size_t encodeSnapshotChanges(const Snapshot& _baseline, const Snapshot& _current, char* _out)
+{
+	if (_current.players.size() > MAX_SNAPSHOT_PLAYERS || _baseline.players.size() > MAX_SNAPSHOT_PLAYERS) {
+		return 0;
+	}
+
+	BitWriter writer(_out, MAX_SNAPSHOT_CHANGES);
+
+	bool pickUpChanged = _current.pickUpActive != _baseline.pickUpActive || _current.pickUpX != _baseline.pickUpX || _current.pickUpY != _baseline.pickUpY;
+	writer.writeBool(pickUpChanged);
+	if (pickUpChanged) {
+		writer.writeBool(_current.pickUpActive);
+		writer.write(_current.pickUpX, POSITION_X.bits);
+		writer.write(_current.pickUpY, POSITION_Y.bits);
+	}
+	bool matchChanged = _current.gameOver != _baseline.gameOver || _current.survivalMillis != _baseline.survivalMillis;
+	writer.writeBool(matchChanged);
+	if (matchChanged) {
+		writer.writeBool(_current.gameOver);
+		writer.write(_current.survivalMillis, 32);
+	}
+
+	//both lists are sorted by slot so one pass finds the added, changed and removed players
+	const std::vector<SnapshotPlayer>& before = _baseline.players;
+	const std::vector<SnapshotPlayer>& after = _current.players;
+	std::size_t nextSlot = 0; //slots are sent as the gap from the previous entry
+	std::size_t b = 0;
+	std::size_t a = 0;
+	while (b < before.size() || a < after.size())
+	{
+		if (a == after.size() || (b < before.size() && SlotID::index(before[b].id) < SlotID::index(after[a].id))) {
+			writer.writeBool(true);
+			writer.writeVarUint(static_cast<std::uint32_t>(SlotID::index(before[b].id) - nextSlot));
+			writer.writeBool(true); //removed
+			nextSlot = SlotID::index(before[b].id) + 1;
+			++b;
+			continue;
+		}
+
+		const SnapshotPlayer& player = after[a++];
+		std::size_t slot = SlotID::index(player.id);
+		const SnapshotPlayer* previous = nullptr;
+		if (b < before.size() && SlotID::index(before[b].id) == slot) {
+			previous = &before[b++];
+			if (previous->id != player.id) {
+				previous = nullptr; //left and someone took the slot, the fresh entry replaces them
+			}
+		}
+
+		bool xChanged = previous == nullptr || previous->x != player.x;
+		bool yChanged = previous == nullptr || previous->y != player.y;
+		if (!xChanged && !yChanged && previous->isIt == player.isIt && previous->invisible == player.invisible) {
+			continue; //unchanged players cost nothing
+		}
+
+		writer.writeBool(true);
+		writer.writeVarUint(static_cast<std::uint32_t>(slot - nextSlot));
+		writer.writeBool(false); //not removed
+		writer.writeBool(previous == nullptr); //fresh
+		if (previous == nullptr) {
+			writer.write(SlotID::generation(player.id), SNAPSHOT_GENERATION_BITS);
+		}
+		writer.writeBool(xChanged);
+		writer.writeBool(yChanged);
+		writer.writeBool(player.isIt);
+		writer.writeBool(player.invisible);
+		if (xChanged) {
+			writer.write(player.x, POSITION_X.bits);
+		}
+		if (yChanged) {
+			writer.write(player.y, POSITION_Y.bits);
+		}
+		nextSlot = slot + 1;
+	}
+	writer.writeBool(false); //end of list
+
+	std::size_t written = writer.flush();
+	if (writer.overflowed()) {
+		return 0;
+	}
+	return written;
+}
+
+bool isEmptySnapshotChanges(std::size_t _changesSize)
+{
+	return _changesSize == 1; //three clear bits, padded to a byte
+}
+
+bool decodeSnapshotDelta(const Snapshot& _baseline, const char* _payload, std::size_t _size, Snapshot& _out)
+{
+	if (_size < sizeof(SnapshotMessage)) {
+		return false;
+	}
+	SnapshotMessage fixed = decodePayload<SnapshotMessage>(_payload);
+	if (fixed.baselineTick != _baseline.tick) {
+		return false;
+	}
+	BitReader reader(_payload + sizeof(SnapshotMessage), _size - sizeof(SnapshotMessage));
+
+	_out.tick = fixed.tick;
+	_out.pickUpActive = _baseline.pickUpActive;
+	_out.pickUpX = _baseline.pickUpX;
+	_out.pickUpY = _baseline.pickUpY;
+	_out.gameOver = _baseline.gameOver;
+	_out.survivalMillis = _baseline.survivalMillis;
+	_out.players.clear();
+
+	if (reader.readBool()) {
+		_out.pickUpActive = reader.readBool();
+		_out.pickUpX = static_cast<std::uint16_t>(reader.read(POSITION_X.bits));
+		_out.pickUpY = static_cast<std::uint16_t>(reader.read(POSITION_Y.bits));
+	}
+	if (reader.readBool()) {
+		_out.gameOver = reader.readBool();
+		_out.survivalMillis = reader.read(32);
+	}
+
+	const std::vector<SnapshotPlayer>& before = _baseline.players;
+	std::size_t nextSlot = 0;
+	std::size_t b = 0;
+	while (reader.readBool() && !reader.failed())
+	{
+		if (_out.players.size() + (before.size() - b) > MAX_SNAPSHOT_PLAYERS) {
+			return false;
+		}
+		std::uint32_t gap = reader.readVarUint();
+		if (gap >= SlotID::MAX_SLOTS - nextSlot) {
+			return false; //past the last slot, entries only ever go up
+		}
+		std::size_t slot = nextSlot + gap;
+		nextSlot = slot + 1;
+
+		while (b < before.size() && SlotID::index(before[b].id) < slot) {
+			_out.players.push_back(before[b++]); //untouched players carry over
+		}
+		bool known = b < before.size() && SlotID::index(before[b].id) == slot;
+
+		SnapshotPlayer player;
+		if (known) {
+			player = before[b++];
+		}
+
+		if (reader.readBool()) { //removed
+			if (!known) {
+				return false;
+			}
+			continue;
+		}
+		bool fresh = reader.readBool();
+		if (fresh) {
+			player = SnapshotPlayer();
+			player.id = SlotID::make(slot, reader.read(SNAPSHOT_GENERATION_BITS));
+		}
+		else if (!known) {
+			return false; //only a fresh entry can fill an empty slot
+		}
+		bool xChanged = reader.readBool();
+		bool yChanged = reader.readBool();
+		if (fresh && !(xChanged && yChanged)) {
+			return false; //new players always come with a full position
+		}
+		player.isIt = reader.readBool();
+		player.invisible = reader.readBool();
+		if (xChanged) {
+			player.x = static_cast<std::uint16_t>(reader.read(POSITION_X.bits));
+		}
+		if (yChanged) {
+			player.y = static_cast<std::uint16_t>(reader.read(POSITION_Y.bits));
+		}
+		_out.players.push_back(player);
+	}
+	_out.players.insert(_out.players.end(), before.begin() + b, before.end());
+
+	return !reader.failed() && reader.atEnd();
+}
+
+Snapshot& SnapshotHistory::store(std::uint32_t _tick)
+{
+	Snapshot& snapshot = snapshots[_tick % SNAPSHOT_HISTORY];
+	snapshot.tick = _tick;
+	return snapshot;
+}
+
+const Snapshot* SnapshotHistory::find(std::uint32_t _tick) const
+{
+	if (_tick == 0) {
+		return &empty;
+	}
+	const Snapshot& snapshot = snapshots[_tick % SNAPSHOT_HISTORY];
+	return snapshot.tick == _tick ? &snapshot : nullptr;
+}
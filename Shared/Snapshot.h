@@ -0,0 +1,105 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BitStream.h"
+#include "Protocol.h"
+#include "SlotMap.h"
+#include "WorldConstants.h"
+
+/// world state as the clients see it, the server captures one per tick and each client
+/// rebuilds the same thing from the changes it is sent against a snapshot it acknowledged
+
+const std::size_t SNAPSHOT_HISTORY = 64; //kept on both sides, about a second at 60 ticks
+
+/// positions cover the screen plus the wrap margin either side, a little finer than a pixel
+const Quantization POSITION_X{ -WRAP_MARGIN, SCREEN_WIDTH + WRAP_MARGIN, 11 };
+const Quantization POSITION_Y{ -WRAP_MARGIN, SCREEN_HEIGHT + WRAP_MARGIN, 10 };
+
+struct SnapshotPlayer
+{
+	std::int32_t id = 0;
+	std::uint16_t x = 0; //quantized with POSITION_X, compared as is so deltas are exact
+	std::uint16_t y = 0; //quantized with POSITION_Y
+	bool isIt = false;
+	bool invisible = false;
+};
+
+struct Snapshot
+{
+	std::uint32_t tick = 0; //0 is the empty world every client starts from
+	std::vector<SnapshotPlayer> players; //sorted by slot so two snapshots can be walked side by side
+
+	bool pickUpActive = false;
+	std::uint16_t pickUpX = 0; //quantized like the players
+	std::uint16_t pickUpY = 0;
+
+	bool gameOver = false;
+	std::uint32_t survivalMillis = 0; //how long red lasted, set with gameOver
+};
+
+/// worst case sizes in bits, a slot gap is at most a few varint chunks of 5 bits
+constexpr std::size_t SNAPSHOT_GENERATION_BITS = 31 - SlotID::INDEX_BITS;
+constexpr std::size_t SNAPSHOT_GAP_BITS = (SlotID::INDEX_BITS + 3) / 4 * 5;
+constexpr std::size_t SNAPSHOT_WORLD_BITS = 1 + 1 + 11 + 10 + 1 + 1 + 32 + 1; //both world fields and the end of list bit
+constexpr std::size_t SNAPSHOT_CHANGED_BITS = 1 + SNAPSHOT_GAP_BITS + 6 + SNAPSHOT_GENERATION_BITS + 11 + 10;
+constexpr std::size_t SNAPSHOT_REMOVED_BITS = 1 + SNAPSHOT_GAP_BITS + 1;
+
+/// a snapshot message is a per client prefix, the header and fixed part, then the changes
+constexpr std::size_t SNAPSHOT_PREFIX_SIZE = messageSize<SnapshotMessage>();
+constexpr std::size_t MAX_SNAPSHOT_CHANGES = MAX_SNAPSHOT_PAYLOAD - sizeof(SnapshotMessage);
+
+/// most players a snapshot can carry, enough room for every one to change and as many again to be removed
+constexpr std::size_t MAX_SNAPSHOT_PLAYERS =
+	(MAX_SNAPSHOT_CHANGES * 8 - SNAPSHOT_WORLD_BITS) / (SNAPSHOT_CHANGED_BITS + SNAPSHOT_REMOVED_BITS);
+
+/// <summary>
+/// writes a whole snapshot message holding only what differs between the two snapshots
+/// unchanged players and world fields are left out entirely
+/// </summary>
+/// <param name="_out">must hold MAX_DATAGRAM_SIZE bytes</param>
+/// <returns>bytes written, header included, 0 if _current has more than MAX_SNAPSHOT_PLAYERS players</returns>
+/// <param name="_lastInput">newest input applied for the receiving client</param>
+std::size_t encodeSnapshotDelta(const Snapshot& _baseline, const Snapshot& _current, std::uint32_t _lastInput, std::uint32_t _sequence, char* _out);
+
+/// <summary>
+/// writes only the changes part of a snapshot message, it depends on nothing but the two snapshots
+/// so every client on the same baseline can be sent the same bytes behind its own prefix
+/// </summary>
+/// <param name="_out">must hold MAX_SNAPSHOT_CHANGES bytes</param>
+/// <returns>bytes written, 0 if _current has more than MAX_SNAPSHOT_PLAYERS players</returns>
+std::size_t encodeSnapshotChanges(const Snapshot& _baseline, const Snapshot& _current, char* _out);
+
+/// <summary>
+/// writes the header and fixed part that go in front of _changesSize bytes of changes
+/// </summary>
+/// <param name="_out">must hold SNAPSHOT_PREFIX_SIZE bytes</param>
+void encodeSnapshotPrefix(std::uint32_t _baselineTick, std::uint32_t _tick, std::uint32_t _lastInput, std::uint32_t _sequence, std::size_t _changesSize, char* _out);
+
+/// <summary>
+/// true if _changesSize bytes from encodeSnapshotChanges say nothing changed since the baseline
+/// </summary>
+bool isEmptySnapshotChanges(std::size_t _changesSize);
+
+/// <summary>
+/// rebuilds a snapshot from its baseline and the changes in a snapshot payload
+/// </summary>
+/// <param name="_baseline">the snapshot named by the payloads baselineTick</param>
+/// <param name="_out">overwritten, its vector capacity is reused</param>
+/// <returns>false if the payload is malformed</returns>
+bool decodeSnapshotDelta(const Snapshot& _baseline, const char* _payload, std::size_t _size, Snapshot& _out);
+
+/// <summary>
+/// the last SNAPSHOT_HISTORY snapshots by tick, used as delta baselines
+/// </summary>
+class SnapshotHistory
+{
+public:
+	Snapshot& store(std::uint32_t _tick); //slot for a new tick, replaces the oldest
+	const Snapshot* find(std::uint32_t _tick) const; //nullptr if never stored or already replaced, tick 0 is always the empty world
+
+private:
+	std::array<Snapshot, SNAPSHOT_HISTORY> snapshots;
+	Snapshot empty;
+};
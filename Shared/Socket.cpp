@@ -0,0 +1,303 @@
+#include "Socket.h"
+#include <iostream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+bool initSockets()
+{
+#ifdef _WIN32
+	WSADATA wsaData;
+	int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
+	if (result != 0) {
+		std::cerr << "WSAStartup failed with error: " << result << "\n";
+		return false;
+	}
+#endif
+	return true;
+}
+
+void shutdownSockets()
+{
+#ifdef _WIN32
+	WSACleanup();  // Cleanup Winsock
+#endif
+}
+
+void closeSocket(SocketHandle _socket)
+{
+#ifdef _WIN32
+	closesocket(_socket);
+#else
+	close(_socket);
+#endif
+}
+
+int lastSocketError()
+{
+#ifdef _WIN32
+	return WSAGetLastError();
+#else
+	return errno;
+#endif
+}
+
+bool isWouldBlock(int _error)
+{
+#ifdef _WIN32
+	return _error == WSAEWOULDBLOCK;
+#else
+	return _error == EWOULDBLOCK || _error == EAGAIN;
+#endif
+}
+
+bool setNonBlocking(SocketHandle _socket, bool _nonBlocking)
+{
+#ifdef _WIN32
+	u_long mode = _nonBlocking ? 1 : 0;
+	return ioctlsocket(_socket, FIONBIO, &mode) == 0;
+#else
+	int flags = fcntl(_socket, F_GETFL, 0);
+	if (flags < 0) {
+		return false;
+	}
+	flags = _nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+	return fcntl(_socket, F_SETFL, flags) == 0;
+#endif
+}
+
+bool setNoDelay(SocketHandle _socket, bool _noDelay)
+{
+	int flag = _noDelay ? 1 : 0;
+	return setsockopt(_socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&flag), sizeof(flag)) == 0;
+}
+
+SocketHandle openListener(unsigned short _port, bool _loopbackOnly)
+{
+	SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP); //tcp socket
+	if (listener == INVALID_SOCKET_HANDLE) {
+		std::cerr << "Error creating socket: " << lastSocketError() << "\n";
+		return INVALID_SOCKET_HANDLE;
+	}
+
+#ifndef _WIN32
+	int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)); //quick restarts on linux
+#endif
+
+	sockaddr_in serverAddr{};
+	serverAddr.sin_family = AF_INET;
+	serverAddr.sin_addr.s_addr = htonl(_loopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+	serverAddr.sin_port = htons(_port); //sets port number and address
+
+	if (bind(listener, reinterpret_cast<sockaddr*>(&serverAddr), sizeof(serverAddr)) != 0) {
+		std::cerr << "Bind failed: " << lastSocketError() << "\n";
+		closeSocket(listener);
+		return INVALID_SOCKET_HANDLE;
+	}
+
+	if (listen(listener, SOMAXCONN) != 0) {
+		std::cerr << "Listen failed: " << lastSocketError() << "\n";
+		closeSocket(listener);
+		return INVALID_SOCKET_HANDLE;
+	}
+
+	return listener;
+}
+
+SocketHandle connectTo(const std::string& _host, unsigned short _port)
+{
+	SocketHandle connection = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (connection == INVALID_SOCKET_HANDLE) {
+		std::cerr << "Error creating socket: " << lastSocketError() << "\n";
+		return INVALID_SOCKET_HANDLE;
+	}
+
+	sockaddr_in serverAddr{};
+	serverAddr.sin_family = AF_INET;
+	inet_pton(AF_INET, _host.c_str(), &serverAddr.sin_addr);
+	serverAddr.sin_port = htons(_port);
+
+	if (connect(connection, reinterpret_cast<sockaddr*>(&serverAddr), sizeof(serverAddr)) != 0) {
+		std::cerr << "Failed to connect to host: " << lastSocketError() << "\n";
+		closeSocket(connection);
+		return INVALID_SOCKET_HANDLE;
+	}
+	setNoDelay(connection, true); //inputs are tiny and late ones are useless
+
+	return connection;
+}
+
+int sendBytes(SocketHandle _socket, const char* _data, std::size_t _size)
+{
+#ifdef _WIN32
+	return send(_socket, _data, static_cast<int>(_size), 0);
+#else
+	return static_cast<int>(send(_socket, _data, _size, MSG_NOSIGNAL)); //no SIGPIPE when a client vanishes
+#endif
+}
+
+int sendBuffers(SocketHandle _socket, const ConstBuffer* _buffers, std::size_t _count)
+{
+	_count = _count < MAX_SEND_BUFFERS ? _count : MAX_SEND_BUFFERS; //the rest goes on the next call like any short write
+#ifdef _WIN32
+	WSABUF pieces[MAX_SEND_BUFFERS];
+	for (std::size_t i = 0; i < _count; ++i) {
+		pieces[i].buf = const_cast<char*>(_buffers[i].data);
+		pieces[i].len = static_cast<ULONG>(_buffers[i].size);
+	}
+	DWORD sent = 0;
+	if (WSASend(_socket, pieces, static_cast<DWORD>(_count), &sent, 0, nullptr, nullptr) != 0) {
+		return -1;
+	}
+	return static_cast<int>(sent);
+#else
+	iovec pieces[MAX_SEND_BUFFERS];
+	for (std::size_t i = 0; i < _count; ++i) {
+		pieces[i].iov_base = const_cast<char*>(_buffers[i].data);
+		pieces[i].iov_len = _buffers[i].size;
+	}
+	msghdr message{};
+	message.msg_iov = pieces;
+	message.msg_iovlen = _count;
+	return static_cast<int>(sendmsg(_socket, &message, MSG_NOSIGNAL)); //writev would raise SIGPIPE
+#endif
+}
+
+int receiveBytes(SocketHandle _socket, char* _data, std::size_t _size)
+{
+#ifdef _WIN32
+	return recv(_socket, _data, static_cast<int>(_size), 0);
+#else
+	return static_cast<int>(recv(_socket, _data, _size, 0));
+#endif
+}
+
+SocketHandle openDatagramSocket(unsigned short _port)
+{
+	SocketHandle datagram = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP); //udp socket
+	if (datagram == INVALID_SOCKET_HANDLE) {
+		std::cerr << "Error creating udp socket: " << lastSocketError() << "\n";
+		return INVALID_SOCKET_HANDLE;
+	}
+
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = INADDR_ANY;
+	address.sin_port = htons(_port);
+
+	if (bind(datagram, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+		std::cerr << "Udp bind failed: " << lastSocketError() << "\n";
+		closeSocket(datagram);
+		return INVALID_SOCKET_HANDLE;
+	}
+
+	setNonBlocking(datagram, true); //drained until it would block
+	return datagram;
+}
+
+bool resolveAddress(const std::string& _host, unsigned short _port, SocketAddress& _address)
+{
+	_address = SocketAddress{};
+	_address.sin_family = AF_INET;
+	_address.sin_port = htons(_port);
+	return inet_pton(AF_INET, _host.c_str(), &_address.sin_addr) == 1;
+}
+
+bool sameAddress(const SocketAddress& _first, const SocketAddress& _second)
+{
+	return _first.sin_addr.s_addr == _second.sin_addr.s_addr && _first.sin_port == _second.sin_port;
+}
+
+int sendDatagram(SocketHandle _socket, const SocketAddress& _to, const char* _data, std::size_t _size)
+{
+#ifdef _WIN32
+	return sendto(_socket, _data, static_cast<int>(_size), 0, reinterpret_cast<const sockaddr*>(&_to), sizeof(_to));
+#else
+	return static_cast<int>(sendto(_socket, _data, _size, 0, reinterpret_cast<const sockaddr*>(&_to), sizeof(_to)));
+#endif
+}
+
+int sendDatagramBatch(SocketHandle _socket, const OutgoingDatagram* _datagrams, std::size_t _count)
+{
+#if defined(__linux__)
+	const std::size_t CHUNK = 32;
+	mmsghdr messages[CHUNK];
+	iovec pieces[CHUNK][MAX_SEND_BUFFERS];
+	std::size_t sent = 0;
+	while (sent < _count)
+	{
+		std::size_t chunk = _count - sent < CHUNK ? _count - sent : CHUNK;
+		for (std::size_t i = 0; i < chunk; ++i)
+		{
+			const OutgoingDatagram& datagram = _datagrams[sent + i];
+			std::size_t count = datagram.count < MAX_SEND_BUFFERS ? datagram.count : MAX_SEND_BUFFERS;
+			for (std::size_t p = 0; p < count; ++p) {
+				pieces[i][p].iov_base = const_cast<char*>(datagram.buffers[p].data);
+				pieces[i][p].iov_len = datagram.buffers[p].size;
+			}
+			messages[i] = mmsghdr{};
+			messages[i].msg_hdr.msg_name = const_cast<SocketAddress*>(&datagram.to);
+			messages[i].msg_hdr.msg_namelen = sizeof(datagram.to);
+			messages[i].msg_hdr.msg_iov = pieces[i];
+			messages[i].msg_hdr.msg_iovlen = count;
+		}
+		int result = sendmmsg(_socket, messages, static_cast<unsigned int>(chunk), 0);
+		if (result <= 0) {
+			return sent > 0 ? static_cast<int>(sent) : -1;
+		}
+		sent += result;
+		if (static_cast<std::size_t>(result) < chunk) {
+			break; //socket buffer is full
+		}
+	}
+	return static_cast<int>(sent);
+#else
+	for (std::size_t i = 0; i < _count; ++i)
+	{
+		const OutgoingDatagram& datagram = _datagrams[i];
+		std::size_t count = datagram.count < MAX_SEND_BUFFERS ? datagram.count : MAX_SEND_BUFFERS;
+#ifdef _WIN32
+		WSABUF pieces[MAX_SEND_BUFFERS];
+		for (std::size_t p = 0; p < count; ++p) {
+			pieces[p].buf = const_cast<char*>(datagram.buffers[p].data);
+			pieces[p].len = static_cast<ULONG>(datagram.buffers[p].size);
+		}
+		DWORD sent = 0;
+		bool failed = WSASendTo(_socket, pieces, static_cast<DWORD>(count), &sent, 0,
+			reinterpret_cast<const sockaddr*>(&datagram.to), sizeof(datagram.to), nullptr, nullptr) != 0;
+#else
+		iovec pieces[MAX_SEND_BUFFERS];
+		for (std::size_t p = 0; p < count; ++p) {
+			pieces[p].iov_base = const_cast<char*>(datagram.buffers[p].data);
+			pieces[p].iov_len = datagram.buffers[p].size;
+		}
+		msghdr message{};
+		message.msg_name = const_cast<SocketAddress*>(&datagram.to);
+		message.msg_namelen = sizeof(datagram.to);
+		message.msg_iov = pieces;
+		message.msg_iovlen = count;
+		bool failed = sendmsg(_socket, &message, 0) < 0;
+#endif
+		if (failed) {
+			return i > 0 ? static_cast<int>(i) : -1;
+		}
+	}
+	return static_cast<int>(_count);
+#endif
+}
+
+int receiveDatagram(SocketHandle _socket, char* _data, std::size_t _size, SocketAddress& _from)
+{
+#ifdef _WIN32
+	int fromSize = sizeof(_from);
+	return recvfrom(_socket, _data, static_cast<int>(_size), 0, reinterpret_cast<sockaddr*>(&_from), &fromSize);
+#else
+	socklen_t fromSize = sizeof(_from);
+	return static_cast<int>(recvfrom(_socket, _data, _size, 0, reinterpret_cast<sockaddr*>(&_from), &fromSize));
+#endif
+}
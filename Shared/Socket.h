@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/// thin portable layer over winsock and bsd sockets so the host and client
+/// build on windows and linux from the same source
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define _WINSOCK_DEPRECATED_NO_WARNINGS
+#include <WinSock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib,"ws2_32.lib")
+
+using SocketHandle = SOCKET;
+const SocketHandle INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+using SocketAddress = sockaddr_in;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+using SocketHandle = int;
+const SocketHandle INVALID_SOCKET_HANDLE = -1;
+using SocketAddress = sockaddr_in;
+#endif
+
+bool initSockets(); //WSAStartup on windows, nothing elsewhere
+void shutdownSockets();
+
+void closeSocket(SocketHandle _socket);
+int lastSocketError();
+bool isWouldBlock(int _error); //true if the error just means try again later
+bool setNonBlocking(SocketHandle _socket, bool _nonBlocking);
+bool setNoDelay(SocketHandle _socket, bool _noDelay); //turns nagle off so small messages go out straight away
+
+/// <summary>
+/// opens a tcp socket bound to every interface, or only to loopback, and listening on the port
+/// </summary>
+/// <returns>INVALID_SOCKET_HANDLE on failure, reason already logged</returns>
+SocketHandle openListener(unsigned short _port, bool _loopbackOnly = false);
+
+/// <summary>
+/// connects a blocking tcp socket to host:port, nagle is turned off
+/// </summary>
+/// <returns>INVALID_SOCKET_HANDLE on failure, reason already logged</returns>
+SocketHandle connectTo(const std::string& _host, unsigned short _port);
+
+int sendBytes(SocketHandle _socket, const char* _data, std::size_t _size); //same results as send
+
+/// one piece of a gathered write, pieces go out back to back as if they were one buffer
+struct ConstBuffer
+{
+	const char* data;
+	std::size_t size;
+};
+
+const std::size_t MAX_SEND_BUFFERS = 16; //most pieces a single gathered write takes
+
+int sendBuffers(SocketHandle _socket, const ConstBuffer* _buffers, std::size_t _count); //one writev, same results as send
+int receiveBytes(SocketHandle _socket, char* _data, std::size_t _size); //same results as recv
+
+/// <summary>
+/// opens a non blocking udp socket bound to every interface, port 0 picks any free port
+/// </summary>
+/// <returns>INVALID_SOCKET_HANDLE on failure, reason already logged</returns>
+SocketHandle openDatagramSocket(unsigned short _port);
+
+bool resolveAddress(const std::string& _host, unsigned short _port, SocketAddress& _address); //dotted ipv4 only
+bool sameAddress(const SocketAddress& _first, const SocketAddress& _second);
+
+int sendDatagram(SocketHandle _socket, const SocketAddress& _to, const char* _data, std::size_t _size); //same results as sendto
+
+/// a datagram gathered from up to MAX_SEND_BUFFERS pieces
+struct OutgoingDatagram
+{
+	SocketAddress to;
+	const ConstBuffer* buffers;
+	std::size_t count;
+};
+
+/// <summary>
+/// sends a batch of datagrams to any mix of addresses, with one sendmmsg per chunk of the batch on linux
+/// </summary>
+/// <returns>how many were sent from the front of the batch, -1 if the first could not be</returns>
+int sendDatagramBatch(SocketHandle _socket, const OutgoingDatagram* _datagrams, std::size_t _count);
+int receiveDatagram(SocketHandle _socket, char* _data, std::size_t _size, SocketAddress& _from); //same results as recvfrom
@@ -0,0 +1,71 @@
+#include "SpatialHash.h"
+#include <algorithm>
+
+SpatialHash::SpatialHash(Fixed _cellSize) :
+	cellSize(_cellSize)
+{
+}
+
+void SpatialHash::update(int _id, Fixed _x, Fixed _y)
+{
+	std::uint64_t cell = key(cellOf(_x), cellOf(_y));
+	auto it = cellOfID.find(_id);
+	if (it != cellOfID.end()) {
+		if (it->second == cell) {
+			return; //most players stay in the same cell from one tick to the next
+		}
+		std::vector<int>& previous = cells[it->second];
+		previous.erase(std::find(previous.begin(), previous.end(), _id));
+		it->second = cell;
+	}
+	else {
+		cellOfID.emplace(_id, cell);
+	}
+	cells[cell].push_back(_id);
+}
+
+void SpatialHash::remove(int _id)
+{
+	auto it = cellOfID.find(_id);
+	if (it == cellOfID.end()) {
+		return;
+	}
+	std::vector<int>& cell = cells[it->second];
+	cell.erase(std::find(cell.begin(), cell.end(), _id));
+	cellOfID.erase(it);
+}
+
+void SpatialHash::clear()
+{
+	cells.clear();
+	cellOfID.clear();
+}
+
+void SpatialHash::query(Fixed _x, Fixed _y, Fixed _radius, std::vector<int>& _out) const
+{
+	std::int32_t minX = cellOf(_x - _radius);
+	std::int32_t maxX = cellOf(_x + _radius);
+	std::int32_t minY = cellOf(_y - _radius);
+	std::int32_t maxY = cellOf(_y + _radius);
+	for (std::int32_t cellY = minY; cellY <= maxY; ++cellY)
+	{
+		for (std::int32_t cellX = minX; cellX <= maxX; ++cellX)
+		{
+			auto it = cells.find(key(cellX, cellY));
+			if (it != cells.end()) {
+				_out.insert(_out.end(), it->second.begin(), it->second.end());
+			}
+		}
+	}
+}
+
+std::int32_t SpatialHash::cellOf(Fixed _value) const
+{
+	std::int32_t cell = _value.raw / cellSize.raw;
+	return _value.raw % cellSize.raw < 0 ? cell - 1 : cell; //division rounds towards zero, cells round down
+}
+
+std::uint64_t SpatialHash::key(std::int32_t _cellX, std::int32_t _cellY)
+{
+	return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(_cellX)) << 32) | static_cast<std::uint32_t>(_cellY);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "FixedPoint.h"
+
+/// <summary>
+/// uniform grid over the world that finds which ids are near a point without looking at all of them
+/// ids stay in their cell between updates and only move when they cross into another one
+/// </summary>
+class SpatialHash
+{
+public:
+	explicit SpatialHash(Fixed _cellSize);
+
+	void update(int _id, Fixed _x, Fixed _y); //adds the id if it is new
+	void remove(int _id);
+	void clear();
+
+	/// <summary>
+	/// appends every id in the cells touched by the square around the point,
+	/// these are only candidates, the caller still does the exact test
+	/// </summary>
+	void query(Fixed _x, Fixed _y, Fixed _radius, std::vector<int>& _out) const;
+
+private:
+	std::int32_t cellOf(Fixed _value) const;
+	static std::uint64_t key(std::int32_t _cellX, std::int32_t _cellY);
+
+	Fixed cellSize;
+	std::unordered_map<std::uint64_t, std::vector<int>> cells; //empty cells are kept, the world is small and they get reused
+	std::unordered_map<int, std::uint64_t> cellOfID;
+};
@@ -0,0 +1,71 @@
+#include "StreamBuffer.h"
+
+StreamBuffer::StreamBuffer(std::size_t _capacity)
+{
+	std::size_t size = 1;
+	while (size < _capacity || size < MAX_MESSAGE_SIZE) {
+		size <<= 1;
+	}
+	data.resize(size);
+	mask = size - 1;
+}
+
+char* StreamBuffer::writePointer()
+{
+	return data.data() + (writeIndex & mask);
+}
+
+std::size_t StreamBuffer::writableBytes() const
+{
+	std::size_t freeBytes = data.size() - size();
+	std::size_t untilWrap = data.size() - (writeIndex & mask);
+	return freeBytes < untilWrap ? freeBytes : untilWrap;
+}
+
+void StreamBuffer::commitWrite(std::size_t _bytes)
+{
+	writeIndex += _bytes;
+}
+
+FrameStatus StreamBuffer::nextFrame(MessageHeader& _header, const char*& _payload)
+{
+	if (size() < sizeof(MessageHeader)) {
+		return FrameStatus::Partial;
+	}
+
+	char headerBytes[sizeof(MessageHeader)];
+	copyOut(readIndex, sizeof(headerBytes), headerBytes);
+	if (!decodeHeader(headerBytes, _header)) {
+		return FrameStatus::Malformed;
+	}
+
+	std::size_t frameSize = sizeof(MessageHeader) + _header.length;
+	if (size() < frameSize) {
+		return FrameStatus::Partial; //rest hasnt arrived yet
+	}
+
+	std::size_t payloadStart = (readIndex + sizeof(MessageHeader)) & mask;
+	if (payloadStart + _header.length <= data.size()) {
+		_payload = data.data() + payloadStart; //contiguous, read in place
+	}
+	else {
+		copyOut(readIndex + sizeof(MessageHeader), _header.length, scratch); //straddles the wrap
+		_payload = scratch;
+	}
+
+	readIndex += frameSize;
+	return FrameStatus::Complete;
+}
+
+void StreamBuffer::copyOut(std::size_t _from, std::size_t _bytes, char* _out) const
+{
+	std::size_t start = _from & mask;
+	std::size_t first = data.size() - start;
+	if (first >= _bytes) {
+		std::memcpy(_out, data.data() + start, _bytes);
+	}
+	else {
+		std::memcpy(_out, data.data() + start, first);
+		std::memcpy(_out + first, data.data(), _bytes - first);
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Protocol.h"
+
+enum class FrameStatus
+{
+	Complete, //a whole message was pulled out
+	Partial, //need more bytes before the next message is whole
+	Malformed //bytes dont decode, the connection should be dropped
+};
+
+/// <summary>
+/// per connection ring buffer that reassembles the tcp byte stream into messages
+/// recv writes straight into the free space and every complete message is pulled
+/// out per wakeup, messages that dont straddle the wrap are read in place
+/// </summary>
+class StreamBuffer
+{
+public:
+	explicit StreamBuffer(std::size_t _capacity = 4096); //rounded up to a power of two
+
+	char* writePointer(); //where the next recv should write
+	std::size_t writableBytes() const; //contiguous free bytes at writePointer
+	void commitWrite(std::size_t _bytes); //marks bytes written by recv as readable
+
+	/// <summary>
+	/// pulls the next whole message out of the buffer
+	/// </summary>
+	/// <param name="_header">filled when Complete</param>
+	/// <param name="_payload">points at the payload when Complete, valid until the next call</param>
+	FrameStatus nextFrame(MessageHeader& _header, const char*& _payload);
+
+	std::size_t size() const { return writeIndex - readIndex; } //unread bytes
+	std::size_t capacity() const { return data.size(); }
+
+private:
+	void copyOut(std::size_t _from, std::size_t _bytes, char* _out) const; //copy that handles the wrap
+
+	std::vector<char> data;
+	std::size_t mask = 0;
+
+	std::size_t readIndex = 0; //running counters, masked when indexing
+	std::size_t writeIndex = 0;
+
+	char scratch[MAX_MESSAGE_SIZE]; //only used for messages split by the wrap
+};
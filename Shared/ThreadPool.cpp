@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(std::size_t _threads)
+{
+	if (_threads == 0) {
+		_threads = std::thread::hardware_concurrency();
+	}
+	if (_threads == 0) {
+		_threads = 1; //unknown core count
+	}
+
+	for (std::size_t i = 0; i < _threads; ++i) {
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+	for (std::size_t i = 1; i < _threads; ++i) {
+		workers.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(batchMutex);
+		stopping = true;
+	}
+	batchStarted.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+/// <summary>
+/// deals the indices out in runs so neighbouring jobs start on the same thread, then helps until the batch is done
+/// </summary>
+void ThreadPool::parallelFor(std::size_t _count, const std::function<void(std::size_t)>& _job)
+{
+	if (_count == 0) {
+		return;
+	}
+	if (workers.empty() || _count == 1) {
+		for (std::size_t i = 0; i < _count; ++i) {
+			_job(i); //nothing to share it with
+		}
+		return;
+	}
+
+	job = &_job;
+	remaining = _count;
+	std::size_t perQueue = (_count + queues.size() - 1) / queues.size();
+	for (std::size_t q = 0; q < queues.size(); ++q)
+	{
+		std::lock_guard<std::mutex> lock(queues[q]->mutex);
+		for (std::size_t i = q * perQueue; i < _count && i < (q + 1) * perQueue; ++i) {
+			queues[q]->indices.push_back(i);
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(batchMutex);
+		++batch;
+	}
+	batchStarted.notify_all();
+
+	while (runOne(0)) {
+	}
+
+	std::unique_lock<std::mutex> lock(batchMutex);
+	batchFinished.wait(lock, [this] { return remaining == 0; }); //stolen jobs may still be running
+}
+
+void ThreadPool::workerLoop(std::size_t _queue)
+{
+	std::uint64_t seenBatch = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(batchMutex);
+			batchStarted.wait(lock, [this, seenBatch] { return stopping || batch != seenBatch; });
+			if (stopping) {
+				return;
+			}
+			seenBatch = batch;
+		}
+		while (runOne(_queue)) {
+		}
+	}
+}
+
+bool ThreadPool::runOne(std::size_t _queue)
+{
+	std::size_t index;
+	if (!take(_queue, index)) {
+		return false;
+	}
+	(*job)(index);
+	if (--remaining == 0) {
+		std::lock_guard<std::mutex> lock(batchMutex); //the caller may be between checking and waiting
+		batchFinished.notify_one();
+	}
+	return true;
+}
+
+bool ThreadPool::take(std::size_t _queue, std::size_t& _index)
+{
+	{
+		WorkQueue& own = *queues[_queue];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.indices.empty()) {
+			_index = own.indices.back();
+			own.indices.pop_back();
+			return true;
+		}
+	}
+	for (std::size_t offset = 1; offset < queues.size(); ++offset)
+	{
+		WorkQueue& other = *queues[(_queue + offset) % queues.size()];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (!other.indices.empty()) {
+			_index = other.indices.front(); //the far end from where its owner is working
+			other.indices.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
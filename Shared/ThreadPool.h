@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// fixed set of worker threads that run batches of independent jobs
+/// each worker has its own queue and takes from the back of it, one that runs dry
+/// steals from the front of the others so a slow job does not hold up the rest of the batch
+/// </summary>
+class ThreadPool
+{
+public:
+	explicit ThreadPool(std::size_t _threads = 0); //0 uses every core, the calling thread counts as one
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/// <summary>
+	/// runs _job once for every index below _count and returns when all of them have finished
+	/// the calling thread works through the batch too, so a pool of one thread is just a loop
+	/// </summary>
+	void parallelFor(std::size_t _count, const std::function<void(std::size_t)>& _job);
+
+	std::size_t getThreadCount() const { return queues.size(); }
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<std::size_t> indices;
+	};
+
+	void workerLoop(std::size_t _queue);
+	bool runOne(std::size_t _queue); //false once every queue is empty
+	bool take(std::size_t _queue, std::size_t& _index); //own queue first, then steals
+
+	std::vector<std::unique_ptr<WorkQueue>> queues; //0 belongs to the thread calling parallelFor
+	std::vector<std::thread> workers;
+
+	const std::function<void(std::size_t)>* job = nullptr; //published before the indices are queued
+	std::atomic<std::size_t> remaining = 0;
+
+	std::mutex batchMutex; //guards batch and stopping, pairs with both conditions
+	std::condition_variable batchStarted;
+	std::condition_variable batchFinished;
+	std::uint64_t batch = 0;
+	bool stopping = false;
+};
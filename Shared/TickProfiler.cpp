@@ -0,0 +1,63 @@
+#include "TickProfiler.h"
+#include <algorithm>
+
+const std::array<double, DurationHistogram::BUCKETS> DurationHistogram::BOUNDS{
+	0.000025, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.0167, 0.025, 0.05, 0.1, 0.25
+};
+
+const char* tickPhaseName(TickPhase _phase)
+{
+	switch (_phase)
+	{
+	case TickPhase::Input:
+		return "input";
+	case TickPhase::Movement:
+		return "movement";
+	case TickPhase::Collision:
+		return "collision";
+	case TickPhase::PickUp:
+		return "pickup";
+	case TickPhase::Broadcast:
+		return "broadcast";
+	default:
+		return "unknown";
+	}
+}
+
+void DurationHistogram::record(double _seconds)
+{
+	std::size_t bucket = std::lower_bound(BOUNDS.begin(), BOUNDS.end(), _seconds) - BOUNDS.begin();
+	++counts[bucket];
+	++count;
+	sum += _seconds;
+}
+
+void DurationHistogram::merge(const DurationHistogram& _other)
+{
+	for (std::size_t i = 0; i < counts.size(); ++i) {
+		counts[i] += _other.counts[i];
+	}
+	count += _other.count;
+	sum += _other.sum;
+}
+
+/// <summary>
+/// phases that did not run this tick are recorded as zero so every phase has one sample per tick
+/// </summary>
+void TickProfiler::finish()
+{
+	using Seconds = std::chrono::duration<double>;
+	for (std::size_t i = 0; i < PHASES; ++i) {
+		phases[i].record(Seconds(current[i]).count());
+		current[i] = Clock::duration::zero();
+	}
+	ticks.record(Seconds(Clock::now() - tickStart).count());
+}
+
+void TickProfiler::merge(const TickProfiler& _other)
+{
+	for (std::size_t i = 0; i < PHASES; ++i) {
+		phases[i].merge(_other.phases[i]);
+	}
+	ticks.merge(_other.ticks);
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// parts of a room tick that are timed separately
+enum class TickPhase
+{
+	Input, //routed events drained into the simulation
+	Movement, //queued inputs applied and the grid updated
+	Collision, //tags checked, including the rewind history
+	PickUp, //spawning, collecting and wearing off, or the game over freeze
+	Broadcast, //snapshots encoded and everything handed to the reactor
+	COUNT
+};
+
+const char* tickPhaseName(TickPhase _phase); //lower case, used as a metric label
+
+/// <summary>
+/// fixed buckets from 25 microseconds to a quarter second, enough to see a phase creep towards the tick budget
+/// counts are per bucket rather than cumulative so recording touches one counter
+/// </summary>
+class DurationHistogram
+{
+public:
+	static const std::size_t BUCKETS = 14;
+	static const std::array<double, BUCKETS> BOUNDS; //upper bound of each bucket in seconds, anything longer counts past the last
+
+	void record(double _seconds);
+	void merge(const DurationHistogram& _other);
+
+	std::uint64_t getBucket(std::size_t _bucket) const { return counts[_bucket]; } //BUCKETS is the overflow
+	std::uint64_t getCount() const { return count; }
+	double getSum() const { return sum; } //seconds
+
+private:
+	std::array<std::uint64_t, BUCKETS + 1> counts{};
+	std::uint64_t count = 0;
+	double sum = 0.0;
+};
+
+/// <summary>
+/// times the phases of one room's tick, the room owns it and only its ticking thread touches it
+/// a tick is cut into laps, each lap is charged to a phase, and the totals are recorded when the tick finishes
+/// so a phase entered twice in one tick still counts once, one clock read per lap keeps it cheap
+/// </summary>
+class TickProfiler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	void start() { lapStart = tickStart = Clock::now(); }
+
+	/// <summary>
+	/// charges the time since the last lap or start to a phase
+	/// </summary>
+	void lap(TickPhase _phase)
+	{
+		Clock::time_point now = Clock::now();
+		current[static_cast<std::size_t>(_phase)] += now - lapStart;
+		lapStart = now;
+	}
+
+	void finish(); //records every phase and the whole tick
+
+	const DurationHistogram& getPhase(TickPhase _phase) const { return phases[static_cast<std::size_t>(_phase)]; }
+	const DurationHistogram& getTick() const { return ticks; }
+
+	void merge(const TickProfiler& _other); //adds another rooms totals, for reporting
+
+private:
+	static const std::size_t PHASES = static_cast<std::size_t>(TickPhase::COUNT);
+
+	Clock::time_point tickStart{};
+	Clock::time_point lapStart{};
+	std::array<Clock::duration, PHASES> current{}; //this tick so far
+
+	std::array<DurationHistogram, PHASES> phases;
+	DurationHistogram ticks;
+};
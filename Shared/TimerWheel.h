@@ -0,0 +1,192 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// hierarchical timer wheel counted in ticks, the caller drives it one tick at a time
+/// level 0 has a slot per tick for the next SLOTS ticks, each level above has slots SLOTS times as wide,
+/// a timer sits in the level its distance fits and drops a level each time its slot comes round,
+/// so scheduling, cancelling and firing are O(1) whatever number of timers are pending
+/// timers due on the same tick fire in the order they were scheduled
+/// </summary>
+template <typename T>
+class TimerWheel
+{
+public:
+	static const int NONE = -1;
+
+	explicit TimerWheel(std::uint64_t _firstTick = 0) : next(_firstTick) {}
+
+	/// <summary>
+	/// fires _value on the first advance that reaches _tick, a tick that has already gone fires on the next one
+	/// </summary>
+	/// <returns>handle for cancel, no longer valid once the timer has fired or been cancelled</returns>
+	int schedule(std::uint64_t _tick, const T& _value)
+	{
+		int node;
+		if (freeNodes.empty()) {
+			node = static_cast<int>(nodes.size());
+			nodes.emplace_back();
+		}
+		else {
+			node = freeNodes.back();
+			freeNodes.pop_back();
+		}
+		nodes[node].value = _value;
+		nodes[node].tick = _tick;
+		place(node);
+		++pending;
+		return node;
+	}
+
+	void cancel(int _timer) //a timer that is pending, even one due on the tick being fired
+	{
+		unlink(_timer);
+		freeNodes.push_back(_timer);
+		--pending;
+	}
+
+	/// <summary>
+	/// steps through every tick up to and including _tick, calling _fire(value) for each timer that comes due
+	/// _fire may schedule and cancel timers, anything it schedules fires on a later tick
+	/// </summary>
+	template <typename Fire>
+	void advance(std::uint64_t _tick, Fire&& _fire)
+	{
+		while (next <= _tick) {
+			if ((next & MASK) == 0) {
+				cascade(1);
+			}
+			Slot& firing = slots[FIRING];
+			firing = slots[next & MASK]; //moved out whole, a timer scheduled while firing may be due in this slot next time round
+			slots[next & MASK] = Slot();
+			for (int node = firing.head; node != NONE; node = nodes[node].next) {
+				nodes[node].slot = FIRING;
+			}
+			++next;
+			while (firing.head != NONE) {
+				int node = firing.head;
+				unlink(node);
+				freeNodes.push_back(node);
+				--pending;
+				_fire(T(nodes[node].value)); //a copy, the node is free for whatever _fire schedules
+			}
+		}
+	}
+
+	void clear(std::uint64_t _firstTick) //drops every timer, the next advance starts at _firstTick
+	{
+		for (Slot& slot : slots) {
+			slot = Slot();
+		}
+		nodes.clear();
+		freeNodes.clear();
+		pending = 0;
+		next = _firstTick;
+	}
+
+	std::size_t size() const { return pending; }
+
+	static const int BITS = 6;
+	static const int LEVELS = 4; //2^24 ticks ahead before a timer has to be placed again, over three days at 60 Hz
+
+private:
+	static const std::uint64_t SLOTS = std::uint64_t{ 1 } << BITS;
+	static const std::uint64_t MASK = SLOTS - 1;
+	static const int FIRING = static_cast<int>(LEVELS * SLOTS); //extra slot holding the timers of the tick being fired
+
+	struct Node
+	{
+		T value{};
+		std::uint64_t tick = 0;
+		int previous = NONE;
+		int next = NONE;
+		int slot = NONE;
+	};
+
+	struct Slot
+	{
+		int head = NONE;
+		int tail = NONE;
+	};
+
+	/// <summary>
+	/// the level is picked by distance from the next tick to fire, the slot by the due tick itself,
+	/// so a slot holds timers for exactly the stretch it will next be emptied for
+	/// </summary>
+	void place(int _node)
+	{
+		std::uint64_t due = std::max(nodes[_node].tick, next);
+		std::uint64_t distance = due - next;
+		int level = 0;
+		while (level + 1 < LEVELS && distance >= (std::uint64_t{ 1 } << (BITS * (level + 1)))) {
+			++level;
+		}
+		if (distance >= (std::uint64_t{ 1 } << (BITS * LEVELS))) {
+			due = next + (std::uint64_t{ 1 } << (BITS * LEVELS)) - 1; //placed again when its slot comes round
+		}
+		int slot = level * static_cast<int>(SLOTS) + static_cast<int>((due >> (BITS * level)) & MASK);
+
+		Node& node = nodes[_node];
+		node.slot = slot;
+		node.next = NONE;
+		node.previous = slots[slot].tail;
+		if (slots[slot].tail != NONE) {
+			nodes[slots[slot].tail].next = _node;
+		}
+		else {
+			slots[slot].head = _node;
+		}
+		slots[slot].tail = _node;
+	}
+
+	void unlink(int _node)
+	{
+		Node& node = nodes[_node];
+		Slot& slot = slots[node.slot];
+		if (node.previous != NONE) {
+			nodes[node.previous].next = node.next;
+		}
+		else {
+			slot.head = node.next;
+		}
+		if (node.next != NONE) {
+			nodes[node.next].previous = node.previous;
+		}
+		else {
+			slot.tail = node.previous;
+		}
+	}
+
+	/// <summary>
+	/// the slot of _level the next tick falls in is about to be the nearest one, so its timers move down,
+	/// a level whose own slot has just wrapped round first pulls from the level above
+	/// </summary>
+	void cascade(int _level)
+	{
+		if (_level >= LEVELS) {
+			return;
+		}
+		std::uint64_t index = (next >> (BITS * _level)) & MASK;
+		if (index == 0) {
+			cascade(_level + 1);
+		}
+		Slot& slot = slots[_level * SLOTS + index];
+		int node = slot.head;
+		slot = Slot();
+		while (node != NONE) {
+			int following = nodes[node].next;
+			place(node);
+			node = following;
+		}
+	}
+
+	std::array<Slot, LEVELS * SLOTS + 1> slots;
+	std::vector<Node> nodes;
+	std::vector<int> freeNodes;
+	std::size_t pending = 0;
+	std::uint64_t next; //first tick not yet fired
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+/// sizes shared by the simulation, host and client, kept free of SFML so the headless server can use them
+
+const int SCREEN_WIDTH = 1200;
+const int SCREEN_HEIGHT = 700;
+
+const float WRAP_MARGIN = 60.f; //how far off screen a player goes before wrapping to the other side
+
+const float PLAYER_RADIUS = 15.f;
+const float PICKUP_RADIUS = 5.f;
+const float PLAYER_SPEED = 3.f; //pixels moved per input, the host applies at most one a tick for each player